@@ -87,14 +87,16 @@ extern uint32_t SystemCoreClock;
 
 #define configUSE_PREEMPTION			1
 #define configUSE_IDLE_HOOK				1
-#define configUSE_TICK_HOOK				0
+#define configUSE_TICK_HOOK				1
 #define configCPU_CLOCK_HZ				( SystemCoreClock )
 #define configTICK_RATE_HZ				( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES			( 5 )
-#define configMINIMAL_STACK_SIZE		( ( unsigned short ) 130 )
-#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 30 * 1024 ) )
+#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 48 * 1024 ) )
+/* Set to 1 to create all DDS tasks, queues and timers (and the idle/timer tasks) from static
+buffers in main.c, so their RAM is fixed at link time. */
+#define configSUPPORT_STATIC_ALLOCATION	0
 #define configMAX_TASK_NAME_LEN			( 10 )
-#define configUSE_TRACE_FACILITY		0
+#define configUSE_TRACE_FACILITY		1
 #define configUSE_16_BIT_TICKS			0
 #define configIDLE_SHOULD_YIELD			1
 #define configUSE_MUTEXES				1
@@ -102,14 +104,23 @@ extern uint32_t SystemCoreClock;
 #define configCHECK_FOR_STACK_OVERFLOW	2
 #define configUSE_RECURSIVE_MUTEXES		1
 #define configUSE_MALLOC_FAILED_HOOK	1
-#define configUSE_APPLICATION_TASK_TAG	0
+#define configUSE_APPLICATION_TASK_TAG	1
 #define configUSE_COUNTING_SEMAPHORES	1
-#define configGENERATE_RUN_TIME_STATS	0
+#define configGENERATE_RUN_TIME_STATS	1
 
-/* Co-routine definitions. */
+/* Co-routine definitions. Set to 1 for co-routine DD-Tasks (release_dd_co_task in main.c). */
 #define configUSE_CO_ROUTINES 		0
 #define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
 
+/* The idle task's stack is configMINIMAL_STACK_SIZE. Co-routine DD-Tasks run their job bodies (with
+the FPU context of a preempted float kernel) and send their completions from the idle hook, so it
+needs to be larger while they are enabled. */
+#if configUSE_CO_ROUTINES
+#define configMINIMAL_STACK_SIZE		( ( unsigned short ) 256 )
+#else
+#define configMINIMAL_STACK_SIZE		( ( unsigned short ) 130 )
+#endif
+
 /* Software timer definitions. */
 #define configUSE_TIMERS				1
 #define configTIMER_TASK_PRIORITY		( 3 )
@@ -125,6 +136,8 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend			1
 #define INCLUDE_vTaskDelayUntil			1
 #define INCLUDE_vTaskDelay				1
+#define INCLUDE_uxTaskGetStackHighWaterMark	1
+#define INCLUDE_xTaskGetIdleTaskHandle	1
 
 /* Cortex-M specific definitions. */
 #ifdef __NVIC_PRIO_BITS
@@ -151,6 +164,43 @@ to all Cortex-M ports, and do not rely on any particular library functions. */
 See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
 #define configMAX_SYSCALL_INTERRUPT_PRIORITY 	( configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY << (8 - configPRIO_BITS) )
 	
+/* Per-job preemption accounting in main.c. Pool workers carry a dd_job_clock as their task tag,
+every other task has a NULL tag and costs one compare per switch. */
+extern void dd_job_switched_in(void *tag);
+extern void dd_job_switched_out(void *tag);
+#define traceTASK_SWITCHED_OUT()	if( pxCurrentTCB->pxTaskTag != NULL ) { dd_job_switched_out( ( void * ) pxCurrentTCB->pxTaskTag ); }
+
+/* Set to 1 to record context switches, priority changes, notifications and queue operations into
+the scheduler trace (dd_trace.c) next to the DDS events. Needs configUSE_TRACE_FACILITY for the TCB
+and queue numbers. The type numbers are dd_trace_type values. */
+#define DD_TRACE_KERNEL		1
+#if DD_TRACE_KERNEL
+extern void dd_trace_switched_in(uint32_t task, uint32_t priority);
+extern void dd_trace_priority_set(uint32_t task, uint32_t priority);
+extern void dd_trace_notify(uint32_t task);
+extern void dd_trace_queue(uint32_t type, uint32_t queue, uint32_t waiting);
+#define traceTASK_SWITCHED_IN()		{ dd_trace_switched_in( pxCurrentTCB->uxTCBNumber, pxCurrentTCB->uxPriority ); if( pxCurrentTCB->pxTaskTag != NULL ) { dd_job_switched_in( ( void * ) pxCurrentTCB->pxTaskTag ); } }
+#define traceTASK_PRIORITY_SET( pxTask, uxNewPriority )	dd_trace_priority_set( ( pxTask )->uxTCBNumber, ( uxNewPriority ) )
+#define traceTASK_NOTIFY()			dd_trace_notify( pxTCB->uxTCBNumber )
+#define traceTASK_NOTIFY_FROM_ISR()	dd_trace_notify( pxTCB->uxTCBNumber )
+#define traceTASK_NOTIFY_GIVE_FROM_ISR()	dd_trace_notify( pxTCB->uxTCBNumber )
+#define traceQUEUE_SEND( pxQueue )				dd_trace_queue( 9, ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_SEND_FROM_ISR( pxQueue )		dd_trace_queue( 9, ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_RECEIVE( pxQueue )			dd_trace_queue( 10, ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting )
+#define traceQUEUE_RECEIVE_FROM_ISR( pxQueue )	dd_trace_queue( 10, ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting )
+#define traceBLOCKING_ON_QUEUE_SEND( pxQueue )		dd_trace_queue( 11, ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting )
+#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue )	dd_trace_queue( 12, ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting )
+#else
+#define traceTASK_SWITCHED_IN()		if( pxCurrentTCB->pxTaskTag != NULL ) { dd_job_switched_in( ( void * ) pxCurrentTCB->pxTaskTag ); }
+#endif
+
+/* Run-time stats clock, TIM5 counting microseconds (dd_time.c). The monitor turns the per-task
+counters into CPU shares. */
+extern void dd_runtime_init(void);
+extern uint32_t dd_runtime_counter(void);
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	dd_runtime_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()			dd_runtime_counter()
+
 /* Normal assert() semantics without relying on the provision of an assert.h
 header file. */
 #define configASSERT( x ) if( ( x ) == 0 ) { taskDISABLE_INTERRUPTS(); for( ;; ); }	
@@ -0,0 +1,298 @@
+#include <console.h>
+
+#ifdef DD_HOST_BUILD
+#include <fcntl.h>
+#include <unistd.h>
+typedef unsigned long UBaseType_t;
+#define CONSOLE_LOCK() 0
+#define CONSOLE_UNLOCK(mask) (void)(mask)
+#else
+#include "../FreeRTOS_Source/include/semphr.h"
+#define CONSOLE_LOCK() portSET_INTERRUPT_MASK_FROM_ISR()
+#define CONSOLE_UNLOCK(mask) portCLEAR_INTERRUPT_MASK_FROM_ISR(mask)
+#endif
+
+char console_buffer[CONSOLE_BUFFER_SIZE];
+/* Free-running positions. Bytes from console_tail to console_head are waiting or being sent. */
+volatile uint32_t console_head = 0;
+volatile uint32_t console_tail = 0;
+/* Bytes handed to the sink and not yet confirmed, 0 when the sink is idle */
+volatile uint32_t console_in_flight = 0;
+volatile uint32_t console_dropped_bytes = 0;
+const console_sink *console_active_sink = NULL;
+#ifndef DD_HOST_BUILD
+/* Blocking writers take turns through console_writer, the one waiting for room sets
+   console_waiting and console_sent gives console_space once bytes are out. */
+TaskHandle_t console_blocking_tasks[CONSOLE_BLOCKING_TASKS];
+SemaphoreHandle_t console_writer = NULL;
+SemaphoreHandle_t console_space = NULL;
+volatile uint8_t console_waiting = 0;
+#if configSUPPORT_STATIC_ALLOCATION
+StaticSemaphore_t console_writer_buffer;
+StaticSemaphore_t console_space_buffer;
+#endif
+#endif
+
+/* Hands the next contiguous run of the buffer to the sink. Called with the lock held. */
+void console_start_next(void)
+{
+    uint32_t offset = console_tail & (CONSOLE_BUFFER_SIZE - 1);
+    uint32_t len = console_head - console_tail;
+
+    if (console_active_sink == NULL || console_in_flight != 0 || len == 0)
+    {
+        return;
+    }
+    if (len > CONSOLE_BUFFER_SIZE - offset)
+    {
+        len = CONSOLE_BUFFER_SIZE - offset;
+    }
+    console_in_flight = len;
+    console_active_sink->start(&console_buffer[offset], len);
+}
+
+/* Output written before this is kept and goes out once the sink is up. */
+void console_init(const console_sink *sink)
+{
+    UBaseType_t mask;
+
+#ifndef DD_HOST_BUILD
+#if configSUPPORT_STATIC_ALLOCATION
+    console_writer = xSemaphoreCreateMutexStatic(&console_writer_buffer);
+    console_space = xSemaphoreCreateBinaryStatic(&console_space_buffer);
+#else
+    console_writer = xSemaphoreCreateMutex();
+    console_space = xSemaphoreCreateBinary();
+#endif
+#endif
+    sink->init();
+    mask = CONSOLE_LOCK();
+    console_active_sink = sink;
+    console_start_next();
+    CONSOLE_UNLOCK(mask);
+}
+
+/* Copies as much of data as fits. If not all of it does and wait is set, the next console_sent
+   wakes the writer. */
+uint32_t console_copy(const char *data, uint32_t len, uint8_t wait)
+{
+    UBaseType_t mask = CONSOLE_LOCK();
+    uint32_t space = CONSOLE_BUFFER_SIZE - (console_head - console_tail);
+    uint32_t i;
+
+    if (len > space)
+    {
+        len = space;
+#ifndef DD_HOST_BUILD
+        if (wait)
+        {
+            console_waiting = 1;
+        }
+#endif
+    }
+    for (i = 0; i < len; i++)
+    {
+        console_buffer[(console_head + i) & (CONSOLE_BUFFER_SIZE - 1)] = data[i];
+    }
+    console_head += len;
+    console_start_next();
+    CONSOLE_UNLOCK(mask);
+
+    return len;
+}
+
+#ifndef DD_HOST_BUILD
+/* Only registered tasks wait, never an interrupt or code running before the scheduler. */
+uint8_t console_may_block(void)
+{
+    TaskHandle_t current;
+    uint32_t i;
+
+    if (__get_IPSR() != 0 || console_space == NULL || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+    {
+        return 0;
+    }
+    current = xTaskGetCurrentTaskHandle();
+    for (i = 0; i < CONSOLE_BLOCKING_TASKS; i++)
+    {
+        if (console_blocking_tasks[i] == current)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Makes writes from task wait for room in the buffer instead of dropping. Meant for tasks off the
+   hot path, such as the log task, everything else keeps dropping when the buffer is full. */
+void console_block_writes(TaskHandle_t task)
+{
+    uint32_t i;
+
+    for (i = 0; i < CONSOLE_BLOCKING_TASKS; i++)
+    {
+        if (console_blocking_tasks[i] == NULL || console_blocking_tasks[i] == task)
+        {
+            console_blocking_tasks[i] = task;
+            return;
+        }
+    }
+    configASSERT(0);
+}
+#endif
+
+/* Backend of _write. Writes from tasks registered with console_block_writes wait until all of data
+   is in the buffer. Anyone else gets as much as fits and returns at once, bytes that do not fit are
+   dropped and counted, so the hot path and interrupts are never held up by the link. */
+int console_write(const char *data, int len)
+{
+    uint32_t written;
+
+#ifndef DD_HOST_BUILD
+    if (console_may_block())
+    {
+        // One blocking writer at a time, so their writes do not interleave
+        xSemaphoreTake(console_writer, portMAX_DELAY);
+        written = console_copy(data, len, 1);
+        while (written < (uint32_t)len)
+        {
+            xSemaphoreTake(console_space, CONSOLE_WAIT);
+            written += console_copy(data + written, len - written, 1);
+        }
+        xSemaphoreGive(console_writer);
+        return written;
+    }
+#endif
+    written = console_copy(data, len, 0);
+    if (written < (uint32_t)len)
+    {
+        console_dropped_bytes += len - written;
+    }
+
+    return written;
+}
+
+/* Called by the sink when len bytes of the run it was given are out. A sink may take fewer bytes
+   than offered, the rest is offered again on the next write. */
+void console_sent(uint32_t len)
+{
+#ifndef DD_HOST_BUILD
+    BaseType_t woken = pdFALSE;
+#endif
+
+    console_tail += len;
+    console_in_flight = 0;
+    if (len > 0)
+    {
+        console_start_next();
+    }
+#ifndef DD_HOST_BUILD
+    if (console_waiting && len > 0)
+    {
+        console_waiting = 0;
+        xSemaphoreGiveFromISR(console_space, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+#endif
+}
+
+uint32_t console_dropped(void)
+{
+    return console_dropped_bytes;
+}
+
+#ifdef DD_HOST_BUILD
+void fd_init(void)
+{
+    fcntl(STDOUT_FILENO, F_SETFL, fcntl(STDOUT_FILENO, F_GETFL) | O_NONBLOCK);
+}
+
+void fd_start(const char *data, uint32_t len)
+{
+    ssize_t written = write(STDOUT_FILENO, data, len);
+
+    console_sent(written > 0 ? (uint32_t)written : 0);
+}
+
+const console_sink console_fd_sink = {fd_init, fd_start};
+#else
+/* USART2 TX (PA2, AF7) through DMA1 stream 6 channel 4. The transfer complete interrupt confirms
+   the run and starts the next one. */
+void usart_dma_init(void)
+{
+    GPIO_InitTypeDef gpio;
+    USART_InitTypeDef usart;
+    DMA_InitTypeDef dma;
+
+    RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA | RCC_AHB1Periph_DMA1, ENABLE);
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_USART2, ENABLE);
+
+    GPIO_StructInit(&gpio);
+    gpio.GPIO_Pin = GPIO_Pin_2;
+    gpio.GPIO_Mode = GPIO_Mode_AF;
+    gpio.GPIO_Speed = GPIO_Speed_50MHz;
+    GPIO_Init(GPIOA, &gpio);
+    GPIO_PinAFConfig(GPIOA, GPIO_PinSource2, GPIO_AF_USART2);
+
+    USART_StructInit(&usart);
+    usart.USART_BaudRate = CONSOLE_BAUD_RATE;
+    usart.USART_Mode = USART_Mode_Tx;
+    USART_Init(USART2, &usart);
+    USART_DMACmd(USART2, USART_DMAReq_Tx, ENABLE);
+    USART_Cmd(USART2, ENABLE);
+
+    DMA_DeInit(DMA1_Stream6);
+    DMA_StructInit(&dma);
+    dma.DMA_Channel = DMA_Channel_4;
+    dma.DMA_PeripheralBaseAddr = (uint32_t)&USART2->DR;
+    dma.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+    dma.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_Init(DMA1_Stream6, &dma);
+    DMA_ITConfig(DMA1_Stream6, DMA_IT_TC, ENABLE);
+
+    // Lowest priority, so CONSOLE_LOCK (BASEPRI) keeps it out while the buffer is updated
+    NVIC_SetPriority(DMA1_Stream6_IRQn, configLIBRARY_LOWEST_INTERRUPT_PRIORITY);
+    NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+}
+
+void usart_dma_start(const char *data, uint32_t len)
+{
+    DMA_ClearFlag(DMA1_Stream6, DMA_FLAG_TCIF6 | DMA_FLAG_HTIF6 | DMA_FLAG_TEIF6 | DMA_FLAG_DMEIF6 | DMA_FLAG_FEIF6);
+    DMA1_Stream6->M0AR = (uint32_t)data;
+    DMA_SetCurrDataCounter(DMA1_Stream6, (uint16_t)len);
+    DMA_Cmd(DMA1_Stream6, ENABLE);
+}
+
+void DMA1_Stream6_IRQHandler(void)
+{
+    UBaseType_t mask;
+
+    if (DMA_GetITStatus(DMA1_Stream6, DMA_IT_TCIF6) != RESET)
+    {
+        DMA_ClearITPendingBit(DMA1_Stream6, DMA_IT_TCIF6);
+        mask = CONSOLE_LOCK();
+        console_sent(console_in_flight);
+        CONSOLE_UNLOCK(mask);
+    }
+}
+
+const console_sink console_usart_dma_sink = {usart_dma_init, usart_dma_start};
+
+/* The original ITM output, still buffered but sent synchronously from the caller. */
+void itm_init(void)
+{
+}
+
+void itm_start(const char *data, uint32_t len)
+{
+    uint32_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        ITM_SendChar(data[i]);
+    }
+    console_sent(len);
+}
+
+const console_sink console_itm_sink = {itm_init, itm_start};
+#endif
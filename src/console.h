@@ -0,0 +1,48 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+/* Standard includes*/
+#include <stdint.h>
+#ifndef DD_HOST_BUILD
+/* Kernel includes. */
+#include "stm32f4xx.h"
+#include "../FreeRTOS_Source/include/FreeRTOS.h"
+#include "../FreeRTOS_Source/include/task.h"
+#endif
+
+/* Bytes of console output that can be waiting for the sink, a power of two */
+#define CONSOLE_BUFFER_SIZE 2048
+#define CONSOLE_BAUD_RATE 115200
+/* Tasks that can be registered with console_block_writes */
+#define CONSOLE_BLOCKING_TASKS 2
+/* Longest a blocking writer sleeps before looking at the buffer again, in case a sink never
+   confirms */
+#define CONSOLE_WAIT pdMS_TO_TICKS(100)
+
+/* Output sink behind _write. start hands the sink one contiguous run of buffered bytes; the sink
+   calls console_sent with the number of bytes it took once they are out (from its interrupt, or
+   straight away for a synchronous sink), which starts the next run. */
+typedef struct console_sink
+{
+    void (*init)(void);
+    void (*start)(const char *data, uint32_t len);
+} console_sink;
+
+#ifdef DD_HOST_BUILD
+extern const console_sink console_fd_sink; // non-blocking write(2) to stdout
+#define CONSOLE_DEFAULT_SINK console_fd_sink
+#else
+extern const console_sink console_usart_dma_sink; // USART2 TX on PA2, fed by DMA1 stream 6
+extern const console_sink console_itm_sink;       // ITM port 0 (SWO), busy-waits per character
+#define CONSOLE_DEFAULT_SINK console_usart_dma_sink
+#endif
+
+void console_init(const console_sink *sink);
+int console_write(const char *data, int len);
+void console_sent(uint32_t len);
+uint32_t console_dropped(void);
+#ifndef DD_HOST_BUILD
+void console_block_writes(TaskHandle_t task);
+#endif
+
+#endif
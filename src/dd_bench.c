@@ -0,0 +1,351 @@
+#include <dd_bench.h>
+#include <dd_task_list.h>
+#include <dd_time.h>
+#include <string.h>
+
+#define BENCH_BATCH 16
+
+uint32_t bench_seed = 12345;
+uint32_t bench_samples[DD_BENCH_SAMPLES];
+#ifdef DD_HOST_BUILD
+uint32_t loop_complete_samples[DD_BENCH_SAMPLES];
+#endif
+
+/* Deterministic pseudo-random deadlines, so runs are comparable */
+uint32_t bench_random(void)
+{
+    bench_seed = bench_seed * 1103515245UL + 12345UL;
+    return bench_seed >> 8;
+}
+
+dd_task bench_job(uint32_t task_id)
+{
+    dd_task task = {0};
+
+    task.t_handle = (TaskHandle_t)(uintptr_t)(task_id | 1); // never dereferenced on the host
+    task.type = PERIODIC;
+    task.task_id = task_id;
+    task.task_number = 1 + task_id % 3;
+    task.absolute_deadline = 1000 + bench_random() % 100000;
+    task.chain = NO_CHAIN;
+    task.slot = NO_SLOT;
+    return task;
+}
+
+void dd_bench_header(void)
+{
+    printf("BENCH,operation,active,min,median,max (%d cycles/us)\n", (int)DD_CYCLES_PER_US);
+}
+
+/* Sorts the samples in place and prints min/median/max. */
+void dd_bench_report(const char *operation, int active, uint32_t *samples, int count)
+{
+    uint32_t key;
+    int i, j;
+
+    for (i = 1; i < count; i++)
+    {
+        key = samples[i];
+        for (j = i - 1; j >= 0 && samples[j] > key; j--)
+        {
+            samples[j + 1] = samples[j];
+        }
+        samples[j + 1] = key;
+    }
+    printf("BENCH,%s,%d,%u,%u,%u\n", operation, active, (unsigned)samples[0], (unsigned)samples[count / 2],
+           (unsigned)samples[count - 1]);
+}
+
+void free_list(dd_task_node **head)
+{
+    while (*head != NULL)
+    {
+        pop(head);
+    }
+}
+
+/*
+The list operations the DDS does per message, on an EDF-sorted list of active jobs:
+  release      insert_at_back + sort_EDF of one job
+  complete     remove_node_by_task_id of a random job + sort_EDF
+  sort         sort_EDF of the already sorted list, done for every message
+  set_priority set_priority over the list
+  snapshot     copy_task_list of the whole list (get_active_tasks)
+  batch        insert_batch_EDF of BENCH_BATCH jobs
+The list is put back to its size between samples, outside the measurement. Scratch memory comes
+from the heap, so builds that never run the benchmark do not pay for it.
+*/
+void dd_bench_lists(void)
+{
+    dd_task_node *list = NULL;
+    dd_task *bench_copy = (dd_task *)malloc(DD_BENCH_MAX_ACTIVE * sizeof(dd_task));
+    dd_task *bench_batch = (dd_task *)malloc(BENCH_BATCH * sizeof(dd_task));
+    dd_task removed;
+    dd_task job;
+    uint32_t next_id = 1;
+    uint32_t start;
+    int active;
+    int sample;
+    int i;
+
+    if (bench_copy == NULL || bench_batch == NULL)
+    {
+        printf("Memory allocation failed.\n");
+        free(bench_copy);
+        free(bench_batch);
+        return;
+    }
+
+    for (active = 1; active <= DD_BENCH_MAX_ACTIVE; active *= 2)
+    {
+        for (i = 0; i < active; i++)
+        {
+            insert_at_back(&list, bench_job(next_id++));
+        }
+        sort_EDF(&list);
+
+        for (sample = 0; sample < DD_BENCH_SAMPLES; sample++)
+        {
+            job = bench_job(next_id++);
+            start = dd_cycles();
+            insert_at_back(&list, job);
+            sort_EDF(&list);
+            bench_samples[sample] = dd_cycles() - start;
+            remove_node_by_task_id(&list, job.task_id, &removed);
+        }
+        dd_bench_report("release", active, bench_samples, DD_BENCH_SAMPLES);
+
+        for (sample = 0; sample < DD_BENCH_SAMPLES; sample++)
+        {
+            copy_task_list(list, bench_copy, active, 0);
+            job = bench_copy[bench_random() % active];
+            start = dd_cycles();
+            remove_node_by_task_id(&list, job.task_id, &removed);
+            sort_EDF(&list);
+            bench_samples[sample] = dd_cycles() - start;
+            insert_at_back(&list, removed);
+            sort_EDF(&list);
+        }
+        dd_bench_report("complete", active, bench_samples, DD_BENCH_SAMPLES);
+
+        for (sample = 0; sample < DD_BENCH_SAMPLES; sample++)
+        {
+            start = dd_cycles();
+            sort_EDF(&list);
+            bench_samples[sample] = dd_cycles() - start;
+        }
+        dd_bench_report("sort", active, bench_samples, DD_BENCH_SAMPLES);
+
+        for (sample = 0; sample < DD_BENCH_SAMPLES; sample++)
+        {
+            start = dd_cycles();
+            set_priority(&list);
+            bench_samples[sample] = dd_cycles() - start;
+        }
+        dd_bench_report("set_priority", active, bench_samples, DD_BENCH_SAMPLES);
+
+        for (sample = 0; sample < DD_BENCH_SAMPLES; sample++)
+        {
+            start = dd_cycles();
+            copy_task_list(list, bench_copy, active, 0);
+            bench_samples[sample] = dd_cycles() - start;
+        }
+        dd_bench_report("snapshot", active, bench_samples, DD_BENCH_SAMPLES);
+
+        for (sample = 0; sample < DD_BENCH_SAMPLES; sample++)
+        {
+            for (i = 0; i < BENCH_BATCH; i++)
+            {
+                bench_batch[i] = bench_job(next_id++);
+            }
+            start = dd_cycles();
+            insert_batch_EDF(&list, bench_batch, BENCH_BATCH);
+            bench_samples[sample] = dd_cycles() - start;
+            for (i = 0; i < BENCH_BATCH; i++)
+            {
+                remove_node_by_task_id(&list, bench_batch[i].task_id, &removed);
+            }
+        }
+        dd_bench_report("batch", active, bench_samples, DD_BENCH_SAMPLES);
+
+        free_list(&list);
+    }
+    free(bench_copy);
+    free(bench_batch);
+}
+
+/* Model of a one-shot generator timer re-armed from its callback (generator_callback in main.c).
+   The callback runs some random lateness after the timer fires, up to a period and a half so some
+   releases are already overdue when the timer is re-armed. The schedule starts a few periods before
+   the tick counter wraps and, with the longest period, wraps it a second time during the run. */
+uint32_t dd_bench_release_drift(void)
+{
+    static const uint32_t periods[] = {7, 500, 4999};
+    uint32_t errors = 0;
+    uint32_t next;
+    uint32_t nominal;
+    uint32_t fire;
+    uint32_t now;
+    uint32_t period;
+    uint32_t origin;
+    uint32_t k;
+    int p;
+
+    for (p = 0; p < (int)(sizeof(periods) / sizeof(periods[0])); p++)
+    {
+        period = periods[p];
+        origin = 0xFFFFFFFFUL - 3 * period;
+        next = origin;
+        fire = origin;
+        for (k = 0; k < DD_BENCH_RELEASES; k++)
+        {
+            nominal = dd_release_advance(&next, period);
+            // Exact in modulo 2^32 arithmetic, like TickType_t
+            if (nominal != origin + k * period)
+            {
+                errors++;
+            }
+            // A timer armed before its release time must fire on it, a late one the tick after arming
+            if (fire != nominal && (int32_t)(fire - nominal) <= 0)
+            {
+                errors++;
+            }
+            now = fire + bench_random() % (period + period / 2 + 1);
+            fire = now + dd_release_delay(next, now);
+            if ((int32_t)(next - now) > 0 && fire != next)
+            {
+                errors++;
+            }
+        }
+    }
+    printf("CHECK,release_drift,%u,%u\n", (unsigned)(DD_BENCH_RELEASES * (sizeof(periods) / sizeof(periods[0]))),
+           (unsigned)errors);
+    return errors;
+}
+
+#ifdef DD_HOST_BUILD
+/* set_priority only needs the call, there is no kernel to talk to */
+volatile UBaseType_t bench_priority;
+
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority)
+{
+    (void)task;
+    bench_priority = priority;
+}
+
+/* Stand-in for a message on a DDS lane. The queue copies it in on send and out on receive. */
+typedef struct bench_message
+{
+    dd_task task;
+    int type;
+    uint32_t sent_us;
+} bench_message;
+
+#define BENCH_LANE_LENGTH 8
+
+bench_message bench_lane[BENCH_LANE_LENGTH];
+uint32_t bench_lane_head = 0;
+uint32_t bench_lane_tail = 0;
+
+void bench_send(const bench_message *message)
+{
+    memcpy(&bench_lane[bench_lane_head++ % BENCH_LANE_LENGTH], message, sizeof(*message));
+}
+
+void bench_receive(bench_message *message)
+{
+    memcpy(message, &bench_lane[bench_lane_tail++ % BENCH_LANE_LENGTH], sizeof(*message));
+}
+
+/* The overdue check at the top of every DDS iteration (move_overdue_tasks), nothing is due here. */
+int bench_overdue_scan(dd_task_node *list, uint32_t now)
+{
+    int overdue = 0;
+
+    for (; list != NULL; list = list->next_task)
+    {
+        overdue += (now > list->task.absolute_deadline);
+    }
+    return overdue;
+}
+
+/*
+Host model of one pass of the DDS message loop (dd_scheduler in main.c) for a release and a
+completion, without the kernel: the message is copied through a lane, the active list is checked
+for overdue jobs, the event is applied and the head job is raised with set_priority.
+  loop_release   send/receive, overdue scan, insert_at_back + sort_EDF, set_priority
+  loop_complete  send/receive, overdue scan, remove_node_by_task_id, insert into the completed list,
+                 sort_EDF, set_priority
+On target DDS_BENCH 1 measures the real loop instead (dds_release/dds_complete).
+*/
+void dd_bench_loop(void)
+{
+    dd_task_node *list = NULL;
+    dd_task_node *completed = NULL;
+    bench_message message;
+    bench_message received;
+    dd_task removed;
+    uint32_t next_id = 1000000;
+    uint32_t start;
+    int active;
+    int sample;
+    int i;
+
+    memset(&message, 0, sizeof(message));
+    for (active = 1; active <= DD_BENCH_MAX_ACTIVE; active *= 2)
+    {
+        for (i = 1; i < active; i++)
+        {
+            insert_at_back(&list, bench_job(next_id++));
+        }
+        sort_EDF(&list);
+
+        for (sample = 0; sample < DD_BENCH_SAMPLES; sample++)
+        {
+            message.task = bench_job(next_id++);
+            message.type = 0;
+            start = dd_cycles();
+            message.sent_us = dd_time_us();
+            bench_send(&message);
+            bench_receive(&received);
+            bench_priority += bench_overdue_scan(list, 0);
+            insert_at_back(&list, received.task);
+            sort_EDF(&list);
+            set_priority(&list);
+            bench_samples[sample] = dd_cycles() - start;
+
+            message.type = 1;
+            start = dd_cycles();
+            message.sent_us = dd_time_us();
+            bench_send(&message);
+            bench_receive(&received);
+            bench_priority += bench_overdue_scan(list, 0);
+            if (remove_node_by_task_id(&list, received.task.task_id, &removed))
+            {
+                insert_at_back(&completed, removed);
+            }
+            sort_EDF(&list);
+            set_priority(&list);
+            loop_complete_samples[sample] = dd_cycles() - start;
+
+            free_list(&completed);
+        }
+        dd_bench_report("loop_release", active, bench_samples, DD_BENCH_SAMPLES);
+        dd_bench_report("loop_complete", active, loop_complete_samples, DD_BENCH_SAMPLES);
+
+        free_list(&list);
+    }
+}
+
+int main(void)
+{
+    uint32_t errors;
+
+    dd_time_init();
+    dd_bench_header();
+    errors = dd_bench_release_drift();
+    dd_bench_lists();
+    dd_bench_loop();
+    return errors != 0;
+}
+#endif
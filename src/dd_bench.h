@@ -0,0 +1,39 @@
+#ifndef DD_BENCH_H
+#define DD_BENCH_H
+
+/* Standard includes*/
+#include <stdint.h>
+
+/* Scheduler overhead benchmarks over active sets of 1 to DD_BENCH_MAX_ACTIVE jobs, in powers of
+   two. Every figure is DD_BENCH_SAMPLES measurements reported as min/median/max, as lines of
+       BENCH,<operation>,<active jobs>,<min>,<median>,<max>
+   in dd_cycles (nanoseconds in host builds), so a CI job can diff them between runs.
+
+   Host build, list operations and a model of the DDS message loop (dd_bench_loop):
+       gcc -O2 -DDD_HOST_BUILD -Isrc src/dd_bench.c src/dd_task_list.c src/dd_time.c -o dd_bench
+   Both first run dd_bench_release_drift, a check rather than a benchmark: it follows a generator's
+   release schedule (dd_release_advance/dd_release_delay) through DD_BENCH_RELEASES releases across
+   tick counter wraps with random callback lateness, and prints
+       CHECK,release_drift,<releases>,<errors>
+   where errors counts releases whose nominal time is off origin + k*T or whose timer did not fire
+   exactly on it. The host build exits non-zero if there are any.
+   On target DDS_BENCH 1 runs the same list sweep followed by full DDS round trips (main.c). Each
+   active job costs about 130 bytes of malloc heap (list node and snapshot copy), hence the smaller
+   target sweep. */
+#ifdef DD_HOST_BUILD
+#define DD_BENCH_MAX_ACTIVE 1024
+#else
+#define DD_BENCH_MAX_ACTIVE 256
+#endif
+#define DD_BENCH_SAMPLES 31
+#define DD_BENCH_RELEASES 1000000
+
+void dd_bench_header(void);
+void dd_bench_report(const char *operation, int active, uint32_t *samples, int count);
+void dd_bench_lists(void);
+uint32_t dd_bench_release_drift(void);
+#ifdef DD_HOST_BUILD
+void dd_bench_loop(void);
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+#include <dd_log.h>
+#include <stdio.h>
+
+dd_log_entry log_ring[DD_LOG_ENTRIES];
+/* Free-running positions, the next message goes to log_head % DD_LOG_ENTRIES */
+volatile uint32_t log_head = 0;
+volatile uint32_t log_tail = 0;
+volatile uint32_t log_dropped = 0;
+
+void dd_log(const char *format, int a, int b, int c, int d, int e, int f)
+{
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    dd_log_entry *entry;
+
+    if (log_head - log_tail >= DD_LOG_ENTRIES)
+    {
+        log_dropped++;
+    }
+    else
+    {
+        entry = &log_ring[log_head & (DD_LOG_ENTRIES - 1)];
+        entry->format = format;
+        entry->args[0] = a;
+        entry->args[1] = b;
+        entry->args[2] = c;
+        entry->args[3] = d;
+        entry->args[4] = e;
+        entry->args[5] = f;
+        log_head++;
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+/*
+Log task, meant to run below everything else. Formats and prints queued messages in order and
+reports drops as they happen. The entry is copied out before printing so the slot can be reused
+while printf runs.
+*/
+void dd_log_task(void *pvParameters)
+{
+    dd_log_entry entry;
+    UBaseType_t mask;
+    uint32_t dropped;
+    uint32_t reported = 0;
+
+    while (1)
+    {
+        while (log_tail != log_head)
+        {
+            mask = portSET_INTERRUPT_MASK_FROM_ISR();
+            entry = log_ring[log_tail & (DD_LOG_ENTRIES - 1)];
+            log_tail++;
+            portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+            printf(entry.format, entry.args[0], entry.args[1], entry.args[2], entry.args[3], entry.args[4],
+                   entry.args[5]);
+        }
+
+        dropped = log_dropped;
+        if (dropped != reported)
+        {
+            printf("LOG: %d messages dropped (%d total)\n", (int)(dropped - reported), (int)dropped);
+            reported = dropped;
+        }
+        vTaskDelay(DD_LOG_PERIOD);
+    }
+}
+
+uint32_t dd_log_dropped(void)
+{
+    return log_dropped;
+}
@@ -0,0 +1,39 @@
+#ifndef DD_LOG_H
+#define DD_LOG_H
+
+/* Standard includes*/
+#include <stdint.h>
+/* Kernel includes. */
+#include "stm32f4xx.h"
+#include "../FreeRTOS_Source/include/FreeRTOS.h"
+#include "../FreeRTOS_Source/include/task.h"
+
+/* Ring capacity in messages, a power of two. The monitor's report takes about 25 entries plus one
+   per task, raise it for larger task sets. */
+#ifndef DD_LOG_ENTRIES
+#define DD_LOG_ENTRIES 64
+#endif
+#define DD_LOG_MAX_ARGS 6
+/* How long the log task sleeps once the ring is empty */
+#define DD_LOG_PERIOD pdMS_TO_TICKS(10)
+
+/* Deferred printf. The caller only copies the format pointer and up to six integer arguments into
+   the ring; dd_log_task formats and prints them later at the lowest priority. The format (and
+   anything it points to) must stay valid until then, so use string literals and integer
+   conversions only (%d, %u, %x, %c). Safe to call from tasks and interrupts. When the ring is full
+   the message is dropped and counted. */
+#define DD_LOG(...) DD_LOG_ARGS(__VA_ARGS__, 0, 0, 0, 0, 0, 0, 0)
+#define DD_LOG_ARGS(format, a, b, c, d, e, f, ...) \
+    dd_log(format, (int)(a), (int)(b), (int)(c), (int)(d), (int)(e), (int)(f))
+
+typedef struct dd_log_entry
+{
+    const char *format;
+    int args[DD_LOG_MAX_ARGS];
+} dd_log_entry;
+
+void dd_log(const char *format, int a, int b, int c, int d, int e, int f);
+void dd_log_task(void *pvParameters);
+uint32_t dd_log_dropped(void);
+
+#endif
@@ -81,18 +81,80 @@ void sort_EDF(dd_task_node **head)
     } while (is_swapped);
 }
 
+/* Insert a batch of tasks into a list that is already sorted by deadline in a single pass.
+   The batch is sorted first (insertion sort, batches are small) and then merged in. */
+void insert_batch_EDF(dd_task_node **head, dd_task *tasks, int count)
+{
+    dd_task_node **link = head;
+    dd_task_node *new_node;
+    dd_task key;
+    int i, j;
+
+    for (i = 1; i < count; i++)
+    {
+        key = tasks[i];
+        for (j = i - 1; j >= 0 && tasks[j].absolute_deadline > key.absolute_deadline; j--)
+        {
+            tasks[j + 1] = tasks[j];
+        }
+        tasks[j + 1] = key;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        while (*link != NULL && (*link)->task.absolute_deadline <= tasks[i].absolute_deadline)
+        {
+            link = &(*link)->next_task;
+        }
+
+        new_node = (dd_task_node *)malloc(sizeof(dd_task_node));
+        if (new_node == NULL)
+        {
+            printf("Memory allocation failed.\n");
+            return;
+        }
+        new_node->task = tasks[i];
+        new_node->next_task = *link;
+        *link = new_node;
+        link = &new_node->next_task;
+    }
+}
+
+/* Jobs still waiting for a worker have no handle yet and are skipped,
+   vTaskPrioritySet(NULL, ...) would change the calling task. The earliest job that has a
+   handle runs, even when an earlier one is still waiting for a worker. */
 void set_priority(dd_task_node **head){
 	dd_task_node* current = *head;
-	vTaskPrioritySet(current->task.t_handle, PRIORITY_MED);
+	int boosted = 0;
 
-	current = current->next_task;
 	while(current!=NULL)
 	{
-		vTaskPrioritySet(current->task.t_handle, PRIORITY_LOW);
+		if (current->task.t_handle != NULL)
+		{
+			vTaskPrioritySet(current->task.t_handle, boosted ? PRIORITY_LOW : PRIORITY_MED);
+			boosted = 1;
+		}
 		current=current->next_task;
 	}
 
 }
+/* Copy up to capacity tasks with seq >= from_seq into out, returns the number copied. */
+size_t copy_task_list(dd_task_node *head, dd_task *out, size_t capacity, uint32_t from_seq)
+{
+    size_t count = 0;
+    dd_task_node *current = head;
+
+    while (current != NULL && count < capacity)
+    {
+        if (current->task.seq >= from_seq)
+        {
+            out[count++] = current->task;
+        }
+        current = current->next_task;
+    }
+    return count;
+}
+
 int get_list_count(dd_task_node *head)
 {
     int count = 0;
@@ -132,6 +194,29 @@ void delete_node_by_task_id(dd_task_node **head, uint32_t task_id) {
     free(temp); // Free memory
 }
 
+/* Same as delete_node_by_task_id, but hands the removed task back to the caller.
+   Returns 1 if the task was found, 0 otherwise. */
+int remove_node_by_task_id(dd_task_node **head, uint32_t task_id, dd_task *removed) {
+    dd_task_node *temp = *head, *prev = NULL;
+
+    while (temp != NULL && temp->task.task_id != task_id) {
+        prev = temp;
+        temp = temp->next_task;
+    }
+
+    if (temp == NULL) return 0;
+
+    if (prev == NULL) {
+        *head = temp->next_task;
+    } else {
+        prev->next_task = temp->next_task;
+    }
+
+    *removed = temp->task;
+    free(temp);
+    return 1;
+}
+
 dd_task_node* create_empty_list(){
 
     dd_task_node *empty_list = (dd_task_node*)malloc(sizeof(dd_task_node));
@@ -143,6 +228,15 @@ dd_task_node* create_empty_list(){
     empty_list->task.task_id = 0;
     empty_list->task.task_number = 0;
     empty_list->task.type = 0;
+    empty_list->task.chain = NO_CHAIN;
+    empty_list->task.stage = 0;
+    empty_list->task.slot = NO_SLOT;
+    empty_list->task.seq = 0;
+    empty_list->task.times.release_us = 0;
+    empty_list->task.times.start_us = 0;
+    empty_list->task.times.completion_us = 0;
+    empty_list->task.times.preempted_us = 0;
+    empty_list->task.times.preemptions = 0;
 
     empty_list->next_task = NULL;
 
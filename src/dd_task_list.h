@@ -5,6 +5,14 @@
 /* Standard includes*/
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef DD_HOST_BUILD
+#include <stdint.h>
+/* Host builds (dd_bench.c) only use the list operations, tasks are opaque handles and the host
+   program supplies vTaskPrioritySet. */
+typedef void *TaskHandle_t;
+typedef unsigned long UBaseType_t;
+void vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority);
+#else
 #include "stm32f4_discovery.h"
 /* Kernel includes. */
 #include "stm32f4xx.h"
@@ -13,6 +21,7 @@
 #include "../FreeRTOS_Source/include/semphr.h"
 #include "../FreeRTOS_Source/include/task.h"
 #include "../FreeRTOS_Source/include/timers.h"
+#endif
 
 #define PRIORITY_HIGH 4
 #define PRIORITY_MED 3
@@ -27,6 +36,17 @@ typedef enum task_type
     APERIODIC
 } task_type;
 
+/* Microsecond timestamps (dd_time_us) over a job's life, 0 where not recorded. Start and preemption
+   are only tracked for pool jobs, whose workers are instrumented through their task tag. */
+typedef struct dd_job_times
+{
+    uint32_t release_us;    // release sent to the DDS
+    uint32_t start_us;      // body started on a worker
+    uint32_t completion_us; // body finished
+    uint32_t preempted_us;  // time switched out between start and completion
+    uint16_t preemptions;
+} dd_job_times;
+
 /* TODO: Extend to include additional info (list of interrupt times ect usefull for debugging Monitor Task). */
 typedef struct dd_task
 {
@@ -37,8 +57,17 @@ typedef struct dd_task
     uint32_t absolute_deadline;
     uint32_t completion_time;
     uint16_t task_number;
+    uint8_t chain; // chain instance this job belongs to, NO_CHAIN for independent jobs
+    uint8_t stage; // stage index within the chain
+    uint8_t slot;  // completion notification bit assigned by the DDS, NO_SLOT if none
+    uint32_t seq;  // order of arrival in the completed/overdue lists, 0 while active
+    dd_job_times times;
 } dd_task;
 
+#define NO_CHAIN 0xFF
+#define NO_SLOT 0xFF
+#define CO_SLOT 0xFE // runs on the co-routine pool, never holds a job slot
+
 typedef struct dd_task_node
 {
     dd_task task;
@@ -54,7 +83,10 @@ void sort_EDF(dd_task_node **head);
 int get_list_count(dd_task_node *head);
 dd_task_node* create_empty_list();
 void delete_node_by_task_id(dd_task_node **head, uint32_t task_id);
+int remove_node_by_task_id(dd_task_node **head, uint32_t task_id, dd_task *removed);
 void set_priority(dd_task_node **head);
+void insert_batch_EDF(dd_task_node **head, dd_task *tasks, int count);
+size_t copy_task_list(dd_task_node *head, dd_task *out, size_t capacity, uint32_t from_seq);
 
 
 #endif // DD_TASK_LIST_H
@@ -0,0 +1,122 @@
+#include <dd_time.h>
+
+/* Returns the nominal release that is due and moves the schedule on by one period. */
+uint32_t dd_release_advance(uint32_t *next, uint32_t period)
+{
+    uint32_t nominal = *next;
+
+    *next += period;
+    return nominal;
+}
+
+/* Ticks from now until the next nominal release, at least 1 so a release that is already late
+   follows on the next tick. */
+uint32_t dd_release_delay(uint32_t next, uint32_t now)
+{
+    uint32_t delay = next - now;
+
+    if ((int32_t)delay <= 0)
+    {
+        delay = 1;
+    }
+    return delay;
+}
+
+#ifdef DD_HOST_BUILD
+#include <time.h>
+
+void dd_time_init(void)
+{
+}
+
+/* Raw counter, wraps. Only differences between two readings are meaningful. */
+uint32_t dd_cycles(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+}
+
+uint32_t dd_time_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000ULL + (uint64_t)now.tv_nsec / 1000);
+}
+
+void dd_runtime_init(void)
+{
+}
+
+uint32_t dd_runtime_counter(void)
+{
+    return dd_time_us();
+}
+#else
+/* DWT cycle counter */
+#define DEMCR (*(volatile uint32_t *)0xE000EDFC)
+#define DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+
+/* Upper half of the 64-bit cycle count, CYCCNT wraps every few seconds. dd_time_us has to be
+   called at least once per wrap (the tick hook does) for the carry to be seen. */
+uint32_t cycles_high = 0;
+uint32_t last_cycles = 0;
+
+void dd_time_init(void)
+{
+    DEMCR |= (1UL << 24); // TRCENA
+    DWT_CTRL |= 1UL;
+}
+
+/* Raw counter, wraps. Only differences between two readings are meaningful. */
+uint32_t dd_cycles(void)
+{
+    return DWT_CYCCNT;
+}
+
+/* Microseconds since the counter was enabled, wraps after about 71 minutes. Safe to call from
+   tasks, interrupts and the kernel's trace hooks. */
+uint32_t dd_time_us(void)
+{
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    uint32_t now = DWT_CYCCNT;
+    uint64_t cycles;
+
+    if (now < last_cycles)
+    {
+        cycles_high++;
+    }
+    last_cycles = now;
+    cycles = ((uint64_t)cycles_high << 32) | now;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+
+    return (uint32_t)(cycles / DD_CYCLES_PER_US);
+}
+
+/* TIM5 free-running at DD_RUNTIME_HZ. It sits on APB1, whose timers run at twice PCLK1 whenever APB1
+   is divided down from HCLK. */
+void dd_runtime_init(void)
+{
+    TIM_TimeBaseInitTypeDef base;
+    RCC_ClocksTypeDef clocks;
+    uint32_t timer_clock;
+
+    RCC_GetClocksFreq(&clocks);
+    timer_clock = (clocks.PCLK1_Frequency == clocks.HCLK_Frequency) ? clocks.PCLK1_Frequency : 2 * clocks.PCLK1_Frequency;
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM5, ENABLE);
+    TIM_TimeBaseStructInit(&base);
+    base.TIM_Prescaler = (uint16_t)(timer_clock / DD_RUNTIME_HZ - 1);
+    base.TIM_Period = 0xFFFFFFFF;
+    TIM_TimeBaseInit(TIM5, &base);
+    TIM_Cmd(TIM5, ENABLE);
+}
+
+uint32_t dd_runtime_counter(void)
+{
+    return TIM5->CNT;
+}
+#endif
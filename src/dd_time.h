@@ -0,0 +1,37 @@
+#ifndef DD_TIME_H
+#define DD_TIME_H
+
+/* Standard includes*/
+#include <stdint.h>
+#ifndef DD_HOST_BUILD
+/* Kernel includes. */
+#include "stm32f4xx.h"
+#include "../FreeRTOS_Source/include/FreeRTOS.h"
+#endif
+
+/* Timestamps for measuring jobs and scheduler overhead below the 1 ms tick. On target they come
+   from the DWT cycle counter, in host builds (DD_HOST_BUILD) from the monotonic clock, with one
+   "cycle" per nanosecond. */
+#ifdef DD_HOST_BUILD
+#define DD_CYCLES_PER_US 1000
+#else
+#define DD_CYCLES_PER_US (configCPU_CLOCK_HZ / 1000000)
+#endif
+
+void dd_time_init(void);
+uint32_t dd_cycles(void);
+uint32_t dd_time_us(void);
+
+/* Periodic release schedule in ticks (TickType_t is 32 bits on this port). Releases are kept at
+   origin + phase + k*T by adding T to the next nominal release, never by measuring from the time a
+   release actually happened, so lateness does not accumulate and the tick counter may wrap. */
+uint32_t dd_release_advance(uint32_t *next, uint32_t period);
+uint32_t dd_release_delay(uint32_t next, uint32_t now);
+
+/* Run-time stats clock for FreeRTOS (configGENERATE_RUN_TIME_STATS), DD_RUNTIME_HZ counts per second
+   from a free-running 32-bit timer, so it wraps after about 71 minutes. */
+#define DD_RUNTIME_HZ 1000000
+void dd_runtime_init(void);
+uint32_t dd_runtime_counter(void);
+
+#endif
@@ -0,0 +1,92 @@
+#include <dd_trace.h>
+#include <stdio.h>
+#ifndef DD_HOST_BUILD
+#include "../FreeRTOS_Source/include/task.h"
+#endif
+
+dd_trace_log dd_trace_log_buffer;
+
+void dd_trace_init(void)
+{
+    dd_trace_log_buffer.magic = DD_TRACE_MAGIC;
+    dd_trace_log_buffer.version = DD_TRACE_VERSION;
+    dd_trace_log_buffer.capacity = DD_TRACE_EVENTS;
+    dd_trace_log_buffer.cycles_per_us = DD_CYCLES_PER_US;
+#ifdef DD_HOST_BUILD
+    dd_trace_log_buffer.tick_rate_hz = 1000;
+#else
+    dd_trace_log_buffer.tick_rate_hz = configTICK_RATE_HZ;
+#endif
+    dd_trace_log_buffer.head = 0;
+}
+
+#if DD_TRACE
+/* Records one event. Writers claim an entry with an atomic increment of head (LDREX/STREX on the
+   Cortex-M4) and then fill it, so tasks, interrupts and the kernel's trace hooks can all record
+   without a lock. An entry being filled when the log is read can be torn, stop the target first. */
+void dd_trace(dd_trace_type type, uint32_t task_id, uint16_t task_number, uint8_t slot)
+{
+    uint32_t index = __atomic_fetch_add(&dd_trace_log_buffer.head, 1, __ATOMIC_RELAXED);
+    dd_trace_event *event = &dd_trace_log_buffer.events[index & (DD_TRACE_EVENTS - 1)];
+
+    event->cycles = dd_cycles();
+#ifdef DD_HOST_BUILD
+    event->tick = event->cycles / (DD_CYCLES_PER_US * 1000);
+#else
+    event->tick = xTaskGetTickCount();
+#endif
+    event->task_id = task_id;
+    event->task_number = task_number;
+    event->type = type;
+    event->slot = slot;
+}
+#endif
+
+/* Kernel trace hooks, called from inside the kernel with the scheduler or interrupts locked, so
+   they only record. */
+void dd_trace_switched_in(uint32_t task, uint32_t priority)
+{
+    dd_trace(TRACE_SWITCH_IN, task, (uint16_t)priority, 0xFF);
+}
+
+void dd_trace_priority_set(uint32_t task, uint32_t priority)
+{
+    dd_trace(TRACE_PRIORITY_SET, task, (uint16_t)priority, 0xFF);
+}
+
+void dd_trace_notify(uint32_t task)
+{
+    dd_trace(TRACE_NOTIFY, task, 0, 0xFF);
+}
+
+void dd_trace_queue(uint32_t type, uint32_t queue, uint32_t waiting)
+{
+    dd_trace((dd_trace_type)type, queue, (uint16_t)waiting, 0xFF);
+}
+
+/* Prints the events recorded since from (a head value) as text lines the exporter also reads, and
+   returns the head to pass next time. Calling it periodically streams an arbitrarily long run as
+   long as fewer than DD_TRACE_EVENTS events arrive in between, overwritten ones are skipped. */
+uint32_t dd_trace_print(uint32_t from)
+{
+    uint32_t head = dd_trace_log_buffer.head;
+    dd_trace_event event;
+
+    if (from == 0)
+    {
+        printf("TRACE-HDR %u %u\n", (unsigned)dd_trace_log_buffer.cycles_per_us,
+               (unsigned)dd_trace_log_buffer.tick_rate_hz);
+    }
+    if (head - from > DD_TRACE_EVENTS)
+    {
+        from = head - DD_TRACE_EVENTS;
+    }
+    for (; from != head; from++)
+    {
+        event = dd_trace_log_buffer.events[from & (DD_TRACE_EVENTS - 1)];
+        printf("TRACE %u %u %u %u %u %u %u\n", (unsigned)from, (unsigned)event.cycles, (unsigned)event.tick,
+               (unsigned)event.task_id, (unsigned)event.task_number, (unsigned)event.type,
+               (unsigned)event.slot);
+    }
+    return head;
+}
@@ -0,0 +1,74 @@
+#ifndef DD_TRACE_H
+#define DD_TRACE_H
+
+/* Standard includes*/
+#include <stdint.h>
+#include <dd_time.h>
+
+/* Set to 0 to compile every dd_trace call out */
+#define DD_TRACE 1
+/* Ring capacity in events, a power of two. 16 bytes each, the oldest events are overwritten. */
+#define DD_TRACE_EVENTS 512
+#define DD_TRACE_MAGIC 0x45435254UL // "TRCE"
+#define DD_TRACE_VERSION 2
+
+/* Scheduler events. tools/dd_trace_export.py decodes the same numbering. */
+typedef enum dd_trace_type
+{
+    TRACE_RELEASE,  // DDS accepted the job into the active list
+    TRACE_DISPATCH, // job body started on a worker
+    TRACE_PREEMPT,  // worker switched out while its job was running
+    TRACE_RESUME,   // preempted worker switched back in
+    TRACE_COMPLETE, // job body finished
+    TRACE_MISS,     // job moved to the overdue list
+    // Kernel events from the trace hooks in FreeRTOSConfig.h (DD_TRACE_KERNEL). task_id holds the
+    // TCB or queue number, task_number the priority or the messages waiting before the operation.
+    TRACE_SWITCH_IN,      // task switched in, with its priority
+    TRACE_PRIORITY_SET,   // vTaskPrioritySet, with the new priority
+    TRACE_NOTIFY,         // task notification sent to the task
+    TRACE_QUEUE_SEND = 9,      // item about to be copied into the queue (numbers used by FreeRTOSConfig.h)
+    TRACE_QUEUE_RECEIVE = 10,  // item copied out of the queue
+    TRACE_QUEUE_BLOCK_TX = 11, // sender blocks on a full queue
+    TRACE_QUEUE_BLOCK_RX = 12  // receiver blocks on an empty queue
+} dd_trace_type;
+
+typedef struct dd_trace_event
+{
+    uint32_t cycles; // dd_cycles()
+    uint32_t tick;   // xTaskGetTickCount()
+    uint32_t task_id;
+    uint16_t task_number;
+    uint8_t type; // dd_trace_type
+    uint8_t slot; // job slot / worker, NO_SLOT if none
+} dd_trace_event;
+
+/* The whole log is self-describing, so a raw memory dump of dd_trace_log is all the exporter needs:
+   (gdb) dump binary value trace.bin dd_trace_log_buffer */
+typedef struct dd_trace_log
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t cycles_per_us;
+    uint32_t tick_rate_hz;
+    volatile uint32_t head; // events ever recorded, the next one goes to head % capacity
+    dd_trace_event events[DD_TRACE_EVENTS];
+} dd_trace_log;
+
+extern dd_trace_log dd_trace_log_buffer;
+
+void dd_trace_init(void);
+#if DD_TRACE
+void dd_trace(dd_trace_type type, uint32_t task_id, uint16_t task_number, uint8_t slot);
+#else
+#define dd_trace(type, task_id, task_number, slot)
+#endif
+uint32_t dd_trace_print(uint32_t from);
+
+/* Entry points for the kernel trace hooks */
+void dd_trace_switched_in(uint32_t task, uint32_t priority);
+void dd_trace_priority_set(uint32_t task, uint32_t priority);
+void dd_trace_notify(uint32_t task);
+void dd_trace_queue(uint32_t type, uint32_t queue, uint32_t waiting);
+
+#endif
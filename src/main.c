@@ -38,6 +38,19 @@ Main Tasks (4):
 	2. User-Defined Tasks (Priority: 3)
 	   - Contains the actual deadline-sensitive application code written by the user.
 	   - Must call complete_dd_task once it hs finished
+	   - Run by a fixed pool of NUM_WORKERS worker tasks created at init. A DD-Task released without an
+	     F-Task handle is given an idle worker by the DDS (earliest deadline first), which runs the job
+	     body, completes the DD-Task and goes back to waiting. Worker i uses job slot i for completions.
+	   - With SRP_POOL 1 the pool shrinks to SRP_LEVELS workers with stack resource policy admission.
+	     Job bodies are plain functions that run to completion without blocking. A waiting job only
+	     starts once it is earlier than every running job, so a started job is only ever preempted
+	     by an earlier one and resumes as soon as that finishes. A running job keeps its level until
+	     it completes, even past its deadline. This bounds how many workers can be busy at once, but
+	     each level is still its own task and stack. When all levels are busy a job waits for one
+	     to free up, so a level too few costs lateness, not memory. A job released after a running
+	     one only nests above it with a shorter relative deadline, and myDDS_Init asserts there are
+	     at least as many levels as distinct relative deadlines in the test bench. Jobs that were
+	     already waiting can nest outside that bound.
 
 	3. Deadline-Driven Task Generator (Priority: 3)
 	   - Periodically creates DD-Tasks that need to be scheduled by the DD Scheduler.
@@ -45,10 +58,16 @@ Main Tasks (4):
 	   - Timer should be configured to expire based on particular DD-Tasks time period
 	   - Prepares all nexesary info for creating specific instances of DD-Tasks, then calls release_dd_task
 	   * Can use single generator to create all DD-Tasks or Multiple generators
-		 --> MULTIPLE GENERATORS
+		 --> ONE GENERIC RELEASE PATH, run by the timer service task for every entry of task_table,
+			 picked by timer ID. GENERATOR_TASKS 1 restores one generator task per entry.
+	   * Task parameters (C, T, D, phase, type, body) come from task_table, selected by TEST_BENCH.
+		 Releases happen at phase + k*T, k >= 0; APERIODIC entries are released once, at phase.
+	   * Each DD-Task carries its nominal release time (origin + phase + k*T, kept in next_release).
+		 Generator timers are one-shot and re-armed against the next nominal release each time, so a
+		 late timer callback delays one release but never shifts the ones after it.
 	   * F-Task handles stored inside each DD-Task may be either created once when app is initialized and re-used
 		 OR F-Task handles continuously created and deleted every time a DD-Task is released and completed (FreeRTOS need to be configured to use heap_4.c instead of heap_1.c for this)
-		 --> CREATED ONCE, heap_1.c
+		 --> CREATED ONCE (worker pool)
 
 	4. Monitor Task (Priority: 4)
 	   - F-Task to extract information from the DDS and report scheduling information.
@@ -56,15 +75,46 @@ Main Tasks (4):
 		1) Number of DD-Tasks
 		2) Number of completed DD-Tasks
 		3) Number of overdue DD-Tasks
-	   - Collects info from DDS using:
-		1) get_active_dd_task_list
-		2) get_complete_dd_task_list
-		3) get_overdue_dd_task_list
+	   - Collects info from DDS using get_dd_stats_histograms, a single round trip that returns counters
+	     the DDS maintains incrementally (no list traversal) together with every task's histograms.
+	     The list getters remain for debugging.
 	   - Print Number of tasks to console
 	   - Must be allowed to execute even if there are active or overdue tasks
 
 	* All 3 Aux tasks should not have access to any internal DS, only interface with DDS via 4 main functions
 
+	* With configSUPPORT_STATIC_ALLOCATION 1 every kernel object created by myDDS_Init (and the idle and
+	  timer service tasks) comes from buffers sized at compile time from task_table, NUM_WORKERS and
+	  the queue lengths, so the DDS's RAM shows up in the link map and start-up cannot fail for lack of
+	  heap. The heap is then only used for list nodes, the benchmarks and co-routines.
+
+	* Run-time stats are on (TIM5, 1 us). The monitor reports the CPU share of the DDS, the idle task,
+	  each worker and the service tasks, and the DDS's CPU time per released job, which is the
+	  scheduler's overhead for the running TEST_BENCH.
+
+	* Output from the DDS and the monitor goes through DD_LOG (dd_log.h): the caller queues the format
+	  and its integer arguments, and the dd_log task formats and prints them at idle priority. A full
+	  log ring drops messages rather than block, the monitor reports how many. printf itself only
+	  copies into the console buffer (console.h), which a DMA-driven USART2 sink drains in the background.
+	  The dd_log task (and the monitor when it streams the trace) waits for room there, everyone else
+	  drops what does not fit.
+
+	* Releases, dispatches, preemptions, completions and misses are recorded into a binary ring
+	  (dd_trace.h) at a few cycles each, together with context switches, priority changes,
+	  notifications and queue operations from the kernel's trace hooks (DD_TRACE_KERNEL).
+	  tools/dd_trace_export.py turns a memory dump of the ring, or the TRACE lines the monitor
+	  prints with TRACE_STREAM 1, into a Chrome/Perfetto trace.
+
+	* Each kind of DDS task has its own stack depth (DDS_STACK_SIZE etc.). Build once with STACK_PROFILE 1
+	  and a full hyperperiod of the intended task set, then apply the depths it prints with
+	  APPLY_STACK_PROFILE 1. Worker stacks must fit the deepest job body, including the FPU context
+	  stacked when a job using floats is preempted. The monitor reports the least free stack of each
+	  task on every run and warns once any task is within STACK_MARGIN words of overflowing.
+
+	* Messages reach the DDS through two lanes: release/complete on the event lane, get_* on the query
+	  lane. Senders ring the DDS doorbell (task notification) after queuing, and the DDS always drains
+	  the event lane before taking the next query, so monitoring traffic never delays a dispatch decision.
+
 Core Functionality:
 
 	1. 	release_dd_task
@@ -73,11 +123,20 @@ Core Functionality:
 	the release time and completion time). The struct is packaged as a message and sent to a queue
 	for the DDS to receive.
 
+	The release time is stamped by the sender, not by the DDS, and the absolute deadline is derived
+	from it, so time spent in the queue does not push deadlines back. release_dd_task_at_async takes
+	an explicit (nominal) release time, which is what the periodic generators use.
+
 	2. 	complete_dd_task
 
 	This function receivesthe ID of the DD-Task which has completed its execution. The ID is packaged
 	as a message and sent to a queue for the DDS to receive.
 
+	When the DDS released the job with a job slot (one of MAX_JOB_SLOTS notification bits), the
+	completion is signalled with xTaskNotify(eSetBits) on that bit instead. Bits accumulate, and a slot
+	is only reused after the DDS has consumed its completion, so no completion can be lost. The DDS
+	handles pending completion bits before anything queued on the lanes.
+
 	3. 	get_active_dd_task_list
 
 	This function sends a message to a queue requesting the Active Task List from the DDS. Once a
@@ -93,18 +152,112 @@ Core Functionality:
 	This function sends a message to a queue requesting the Overdue Task List from the DDS. Once a
 	response is received from the DDS, the function returns the list
 
+	6. 	release_dd_chain
+
+	This function releases one instance of a precedence-constrained chain (a DAG of stages, e.g.
+	sense->compute->actuate). The DDS releases each stage itself as soon as all of its predecessors
+	have completed, so no generator task or extra queue hop is needed between stages. Each stage gets
+	an intermediate deadline derived from the chain's end-to-end deadline in proportion to the
+	execution time along the longest path leading up to (and including) that stage.
+
+	7. 	release_dd_task_batch
+
+	This function hands a whole set of releases (e.g. everything due at a hyperperiod boundary) to the
+	DDS as one message. The DDS merges them into the active list in one pass and makes a single
+	dispatch decision. The caller blocks until the DDS has consumed the batch, so the job descriptors
+	may live on the caller's stack.
+
+	8. 	get_active_tasks / get_completed_tasks / get_overdue_tasks
+
+	These functions copy a bounded snapshot of a list into caller-provided memory within one DDS round
+	trip, so callers never hold pointers into live lists. Completed and overdue DD-Tasks are numbered
+	in the order they leave the active list (dd_task.seq), so history can be paged through by passing
+	the last seq seen + 1 as from_seq.
+
+	9. 	get_dd_stats
+
+	This function sends a message to a queue requesting a copy of the scheduler statistics. The DDS
+	updates the counters on every release/complete/overdue event, so the cost of a query does not
+	depend on how many DD-Tasks have been processed. It also carries the number of messages of each
+	type the DDS has taken off its lanes, and for each DDS queue the peak number of messages waiting,
+	how many sends found it full or receives found it empty, and how long they stayed blocked (us).
+	The monitor flags a queue whose peak comes within QUEUE_WARN_PERCENT of its capacity.
+
+	get_dd_histograms copies one task's log-bucketed histograms of response time, release jitter,
+	lateness and slack (in us, from the jobs' dd_job_times), from which hist_percentile gives tail
+	values such as p99. Lateness and slack are taken against the job's absolute deadline, the same
+	one the DDS counts misses against. get_dd_stats_histograms returns the stats and the histograms
+	of every task in one reply.
+
+	10. *_async variants
+
+	Every function above (except the legacy list getters) has a non-blocking variant that returns a
+	ticket immediately, or DD_TICKET_NONE if the lane is full or no ticket is free (counted as a
+	rejected send). Once the DDS has processed the request, the callback runs in the callback service
+	task, or the ticket can be polled with dd_ticket_poll. dd_ticket_release drops interest in a ticket.
+	Any memory passed to an async request must stay valid until the ticket is done. Blocking sends
+	that find their lane full are counted as retried sends, which together with the queue peaks in
+	dd_stats is what MESSAGE_QUEUE_SIZE should be sized against.
+
+	11. release_dd_co_task / complete_dd_co_task
+
+	Lightweight DD-Tasks for large numbers of small jobs (set configUSE_CO_ROUTINES to 1). The DDS
+	tracks them like any other DD-Task (deadlines, completed/overdue lists, stats) but hands them to
+	the co-routine pool instead of a worker. The pool holds up to MAX_CO_JOBS jobs, each costing one
+	dd_co_job entry instead of a TCB and stack. A dispatcher co-routine runs from the idle hook on the
+	idle task's stack, which FreeRTOSConfig.h enlarges while co-routines are enabled because job
+	bodies and completion messages run on it. It always runs a one-tick slice (one tick of calibrated
+	CPU work) of the earliest-deadline ready job, so between themselves co-routine jobs are scheduled
+	EDF at tick granularity. Because they run at idle priority, they only get the CPU that F-Task
+	DD-Tasks leave free. complete_dd_co_task never blocks and returns pdFAIL if the event lane is full.
+
 */
 
 // ms = tick * portTICK_PERIOD_MS
 
 /* Custom includes. */
 #include "dd_task_list.h"
+#include "workload.h"
+#include "dd_time.h"
+#include "dd_trace.h"
+#include "dd_log.h"
+#include "console.h"
+#include "dd_bench.h"
+#if configUSE_CO_ROUTINES
+#include "../FreeRTOS_Source/include/croutine.h"
+#endif
 
 #define PRIORITY_HIGH 4
 #define PRIORITY_MED 3
 #define PRIORITY_LOW 1
+#define PRIORITY_SERVICE 2
+#define PRIORITY_LOG tskIDLE_PRIORITY
 #define MESSAGE_QUEUE_SIZE 50
+/* The monitor warns when a queue's peak occupancy reaches this share of its capacity */
+#define QUEUE_WARN_PERCENT 75
+/* DDS doorbell bits, set by senders after queuing a message */
+#define DDS_NOTIFY_EVENTS 0x40000000UL
+#define DDS_NOTIFY_QUERIES 0x80000000UL
+/* Remaining notification bits are job slots, set by jobs on completion */
+#define MAX_JOB_SLOTS 30
+#define JOB_SLOT_MASK ((1UL << MAX_JOB_SLOTS) - 1)
+/* Set to 1 to run pool jobs to completion under stack resource policy admission: a job is only
+   started when its deadline is earlier than that of every job already running, so running jobs
+   nest like a stack and the pool needs only SRP_LEVELS workers (one per nesting level) */
+#define SRP_POOL 0
+/* At least the number of distinct relative deadlines in the test bench, asserted by myDDS_Init.
+   CHAIN_TEST adds one per chain stage. */
+#define SRP_LEVELS 4
+/* The first NUM_WORKERS job slots belong to the worker pool */
+#if SRP_POOL
+#define NUM_WORKERS SRP_LEVELS
+#else
+#define NUM_WORKERS 6
+#endif
+#define WORKER_MASK ((1UL << NUM_WORKERS) - 1)
 #define MONITOR_PERIOD pdMS_TO_TICKS(2000)
+/* task_id = task_number * TASK_ID_STRIDE + release count */
+#define TASK_ID_STRIDE 1000000
 
 /* TEST BENCH */
 #define TEST_BENCH 1
@@ -112,124 +265,582 @@ Core Functionality:
 /* Set to 1 for additional print statements,
    adds overhead set to 0 and use debugger for final results */
 #define PRINT_TEST 1
+/* Set to 1 to periodically release the example chain alongside the test bench */
+#define CHAIN_TEST 0
+#define CHAIN_PERIOD pdMS_TO_TICKS(1500)
+/* Set to 1 to replace the test bench with the DDS benchmarks (release bursts, completion paths) */
+#define DDS_BENCH 0
+#define BENCH_REPETITIONS 100
+#define CO_BENCH_JOBS 128
+/* Set to 1 to release through one generator task per table entry instead of straight from the
+   timer callback, kept to compare release jitter between the two paths */
+#define GENERATOR_TASKS 0
+/* Set to 1 to have the monitor print the scheduler trace recorded since its last run, for
+   tools/dd_trace_export.py. DD_TRACE in dd_trace.h turns the recording itself on and off. */
+#define TRACE_STREAM 0
+/* Set to 1 to have the monitor report the peak stack use of every DDS task once the first
+   HYPER_PERIOD has run, printed as stack depth defines (peak + STACK_MARGIN, rounded up to 8 words).
+   Paste them into the APPLY_STACK_PROFILE block below and set that to 1 to build with them. */
+#define STACK_PROFILE 0
+#define STACK_MARGIN 32
+#define APPLY_STACK_PROFILE 0
+
+/* Stack depths in words */
+#if APPLY_STACK_PROFILE
+/* STACK_PROFILE output goes here, any depth it does not print keeps its default below */
+#endif
+/* Defaults: the deepest call path of each task (-fstack-usage) plus the FPU exception frame and
+   STACK_MARGIN, so the profiling build itself runs with room to spare */
+#ifndef DDS_STACK_SIZE
+#define DDS_STACK_SIZE 384
+#endif
+#ifndef MONITOR_STACK_SIZE
+#define MONITOR_STACK_SIZE 384
+#endif
+#ifndef SERVICE_STACK_SIZE
+#define SERVICE_STACK_SIZE 256
+#endif
+#ifndef LOG_STACK_SIZE
+#define LOG_STACK_SIZE 256
+#endif
+#ifndef WORKER_STACK_SIZE
+#define WORKER_STACK_SIZE 256
+#endif
+#ifndef GENERATOR_STACK_SIZE
+#define GENERATOR_STACK_SIZE 256
+#endif
+
+/* Task descriptor, task_table[i] describes task_number i + 1. All times in ms. */
+typedef struct dd_task_desc
+{
+	int execution; // C
+	int period;	   // T
+	int deadline;  // D, relative to release
+	int phase;	   // first release
+	task_type type;
+	void (*body)(dd_task *job);
+	workload_kind workload; // kernel user_defined runs for C
+} dd_task_desc;
+
+void user_defined(dd_task *job);
 
 #ifdef TEST_BENCH
 #if TEST_BENCH == 1
 /* Test Bench #1 */
-#define t1_execution 95
-#define t1_period 500
-#define t2_execution 150
-#define t2_period 500
-#define t3_execution 250
-#define t3_period 750
+const dd_task_desc task_table[] = {
+	{95, 500, 500, 0, PERIODIC, user_defined, WORKLOAD_ALU},
+	{150, 500, 500, 0, PERIODIC, user_defined, WORKLOAD_MEMORY},
+	{250, 750, 750, 0, PERIODIC, user_defined, WORKLOAD_FIR}};
 #elif TEST_BENCH == 2
 /* Test Bench #2 */
-#define t1_execution 95
-#define t1_period 250
-#define t2_execution 150
-#define t2_period 500
-#define t3_execution 250
-#define t3_period 750
+const dd_task_desc task_table[] = {
+	{95, 250, 250, 0, PERIODIC, user_defined, WORKLOAD_ALU},
+	{150, 500, 500, 0, PERIODIC, user_defined, WORKLOAD_MEMORY},
+	{250, 750, 750, 0, PERIODIC, user_defined, WORKLOAD_FIR}};
 #elif TEST_BENCH == 3
 /* Test Bench #3 */
-#define t1_execution 100
-#define t1_period 500
-#define t2_execution 200
-#define t2_period 500
-#define t3_execution 200
-#define t3_period 500
+const dd_task_desc task_table[] = {
+	{100, 500, 500, 0, PERIODIC, user_defined, WORKLOAD_ALU},
+	{200, 500, 500, 0, PERIODIC, user_defined, WORKLOAD_MEMORY},
+	{200, 500, 500, 0, PERIODIC, user_defined, WORKLOAD_FIR}};
 #else
 #error "Invalid test bench specified"
 #endif
 #endif
+
+#define NUM_TASKS (sizeof(task_table) / sizeof(task_table[0]))
+
+/* Chain (DAG job) definitions */
+#define MAX_CHAIN_STAGES 8
+#define MAX_CHAIN_INSTANCES 4
+#define CHAIN_TASK_NUMBER 0
+
+typedef struct dd_chain_stage
+{
+	int execution;		  // ms
+	uint8_t predecessors; // bitmask of stages that must complete first, all with a lower index
+} dd_chain_stage;
+
+typedef struct dd_chain
+{
+	const dd_chain_stage *stages;
+	uint8_t num_stages;
+	int deadline; // end-to-end, ms from chain release
+} dd_chain;
+
+typedef struct dd_chain_instance
+{
+	const dd_chain *chain; // NULL when the slot is free
+	TickType_t release_time;
+	uint8_t released;  // bitmask of stages handed to the DDS
+	uint8_t completed; // bitmask of stages that finished (or missed)
+} dd_chain_instance;
+
+/* Example sense -> compute -> actuate chain */
+const dd_chain_stage sense_compute_actuate[] = {
+	{20, 0x00},
+	{50, 0x01},
+	{10, 0x02}};
+
+const dd_chain chains[] = {
+	{sense_compute_actuate, 3, 400}};
+
+#define NUM_CHAINS (sizeof(chains) / sizeof(chains[0]))
+
+/* DDS intake lanes, drained in this order */
+typedef enum dd_lane
+{
+	LANE_EVENTS,
+	LANE_QUERIES,
+	NUM_LANES
+} dd_lane;
+
+/* DDS queues, numbered from 1 in kernel trace events and monitor output */
+typedef enum dd_queue
+{
+	QUEUE_EVENTS,
+	QUEUE_QUERIES,
+	QUEUE_RESPONSES,
+	QUEUE_CALLBACKS,
+	NUM_QUEUES
+} dd_queue;
+
+/* Occupancy and backpressure of one DDS queue. Waits of the callback service for work are idle
+   time, not backpressure, so they are not counted. */
+typedef struct dd_queue_stats
+{
+	uint32_t capacity;
+	uint32_t peak;			   // most messages waiting at once, sampled after each send
+	uint32_t blocked_sends;	   // sends that found the queue full and waited
+	uint32_t blocked_receives; // receives that found the queue empty and waited
+	uint32_t send_blocked_us;  // total time spent waiting in those sends
+	uint32_t receive_blocked_us;
+} dd_queue_stats;
+
 typedef enum message_type message_type;
 enum message_type
 {
 	release,
+	release_chain,
+	release_batch,
 	complete,
 	get_active,
 	get_completed,
-	get_overdue
+	get_overdue,
+	get_stats,
+	snapshot_active,
+	snapshot_completed,
+	snapshot_overdue,
+	get_histograms,
+	NUM_MESSAGE_TYPES
 };
 
+/* Scheduler statistics, maintained incrementally by the DDS. */
+typedef struct dd_stats
+{
+	uint32_t active_count;
+	uint32_t completed_count;
+	uint32_t overdue_count;
+	uint32_t released_count;
+	uint32_t misses[NUM_TASKS + 1]; // indexed by task_number
+	TickType_t max_lateness;
+	uint32_t utilisation; // sum of C/T of active DD-Tasks, per-mille
+	uint32_t lane_messages[NUM_LANES];
+	uint64_t lane_latency_total_us[NUM_LANES]; // between send and DDS receive
+	uint32_t lane_latency_max_us[NUM_LANES];
+	uint32_t notify_completions; // completions signalled through a job slot
+	uint32_t rejected_sends[NUM_LANES]; // async sends refused because the lane or ticket table was full
+	uint32_t retried_sends[NUM_LANES];	// blocking sends that had to wait for space
+	uint32_t lost_releases[NUM_TASKS + 1]; // generator releases refused by a full lane or ticket table
+	uint32_t messages[NUM_MESSAGE_TYPES]; // messages taken off the lanes, by type
+	dd_queue_stats queues[NUM_QUEUES];
+} dd_stats;
+
+/* Per-task outcome histograms in microseconds, updated by the DDS in O(1) per job. Buckets are
+   logarithmic: 0 and 1 have their own bucket, above that every power of two is split in two, so a
+   value is known to within 50% and the last bucket (from 3 * 2^22 us, about 12.6 s) collects the rest. */
+#define HIST_BUCKETS 48
+
+typedef enum dd_metric
+{
+	METRIC_RESPONSE, // completion - release
+	METRIC_JITTER,	 // deviation of the release interval from T, periodic tasks only
+	METRIC_LATENESS, // completion - deadline, late jobs only
+	METRIC_SLACK,	 // deadline - completion, jobs that met their deadline
+	NUM_METRICS
+} dd_metric;
+
+typedef struct dd_histogram
+{
+	uint32_t count;
+	uint32_t max;
+	uint32_t buckets[HIST_BUCKETS];
+} dd_histogram;
+
+typedef struct dd_histograms
+{
+	dd_histogram metric[NUM_METRICS];
+} dd_histograms;
+
+/* Asynchronous requests */
+#define MAX_TICKETS 16
+#define DD_TICKET_NONE 0
+
+typedef uint32_t dd_ticket;
+typedef void (*dd_callback)(dd_ticket ticket, void *context);
+
+typedef enum dd_ticket_state
+{
+	TICKET_UNKNOWN, // never issued, or already released
+	TICKET_PENDING,
+	TICKET_DONE
+} dd_ticket_state;
+
+typedef struct dd_ticket_slot
+{
+	dd_ticket ticket; // DD_TICKET_NONE when the slot is free
+	dd_ticket_state state;
+	dd_callback callback;
+	void *context;
+	uint8_t released; // nobody will poll, free as soon as it is done
+} dd_ticket_slot;
+
+#define MAX_BATCH_SIZE 16
+
+/* Everything needed to release one DD-Task, see release_dd_task */
+typedef struct job_desc
+{
+	TaskHandle_t t_handle;
+	task_type type;
+	uint32_t task_id;
+	uint16_t task_number;
+} job_desc;
+
 typedef struct dd_message
 {
 	dd_task task;
 	message_type type;
 	dd_task_node *list;
+	dd_stats *stats;
+	TickType_t sent_time;
+	uint32_t sent_us; // dd_time_us at send, for lane latency
+	dd_task *snapshot; // snapshot_* only, caller-owned
+	size_t capacity;
+	uint32_t from_seq;
+	size_t *count;
+	dd_histograms *histograms; // get_histograms for task.task_number, get_stats for all tasks if not NULL
+	const job_desc *jobs;	   // release_batch only
+	size_t num_jobs;
+	TaskHandle_t sender; // notified once a batch has been consumed
+	dd_ticket ticket;	 // DD_TICKET_NONE for blocking requests
 } dd_message;
 
 /* Prototypes. */
 TaskHandle_t pxDDS;
 TaskHandle_t pxMonitor;
-TaskHandle_t pxTaskGen1;
-TaskHandle_t pxTaskGen2;
-TaskHandle_t pxTaskGen3;
+TaskHandle_t pxCallbackService;
+TaskHandle_t pxLog;
+#if GENERATOR_TASKS
+TaskHandle_t pxGenerators[NUM_TASKS];
+#endif
 
 void myDDS_Init();
+BaseType_t create_task(TaskFunction_t code, const char *name, uint16_t stack_depth, void *parameters,
+					   UBaseType_t priority, TaskHandle_t *handle, StackType_t *stack, StaticTask_t *tcb);
+QueueHandle_t create_queue(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *buffer);
+TimerHandle_t create_timer(const char *name, TickType_t period, UBaseType_t auto_reload, void *id,
+						   TimerCallbackFunction_t callback, StaticTimer_t *buffer);
 void results_Init();
+uint32_t add_deadline(TickType_t *seen, uint32_t count, TickType_t deadline);
+uint32_t count_relative_deadlines(void);
 void dd_scheduler(void *pvParameters);
-void dd_task_generator_1(void *pvParameters);
-void dd_task_generator_2(void *pvParameters);
-void dd_task_generator_3(void *pvParameters);
-void user_defined(void *pvParameters);
+#if GENERATOR_TASKS
+void dd_task_generator(void *pvParameters);
+#endif
+void generate_release(uint32_t index, TickType_t nominal);
+void release_next(uint32_t index);
+void dd_worker(void *pvParameters);
+void stamp_release(dd_job_times *times);
+void dd_job_switched_in(void *tag);
+void dd_job_switched_out(void *tag);
+void assign_workers(dd_task_node *active_list);
 void monitor(void *pvParameters);
+void print_stack_profile(void);
+void print_stack_depth(const char *name, uint32_t depth, UBaseType_t free);
 void release_dd_task(TaskHandle_t t_handle,
 					 task_type type,
 					 uint32_t task_id,
 					 uint16_t task_number);
 int get_execution_time(uint16_t task_number);
 TickType_t get_period_TICKS(uint16_t task_number);
+TickType_t get_deadline_TICKS(uint16_t task_number);
+void (*get_task_body(uint16_t task_number))(dd_task *job);
+workload_kind get_task_workload(uint16_t task_number);
+uint32_t get_utilisation(uint16_t task_number);
 void print_event(int event_num, int task_num, message_type type, int measured_time);
-void move_overdue_tasks(dd_task_node **active_list, dd_task_node **overdue_list);
+void move_overdue_tasks(dd_task_node **active_list, dd_task_node **overdue_list, dd_stats *stats);
+void record_overdue(dd_task *task, dd_stats *stats);
+void send_to_dds(dd_message *message);
+BaseType_t send_message(dd_message *message, TickType_t wait);
+BaseType_t queue_send(dd_queue id, xQueueHandle queue, const void *item, TickType_t wait);
+BaseType_t queue_receive(dd_queue id, xQueueHandle queue, void *item, TickType_t wait);
+void queue_peak(dd_queue id, xQueueHandle queue);
+dd_lane get_lane(message_type type);
+void reply_to_sender(dd_message *message);
+dd_ticket send_async(dd_message *message, dd_callback callback, void *context);
+dd_ticket_slot *find_ticket(dd_ticket ticket);
+void complete_ticket(dd_ticket ticket);
+void free_ticket(dd_ticket_slot *slot);
+void dd_callback_service(void *pvParameters);
+
+dd_ticket release_dd_task_async(TaskHandle_t t_handle, task_type type, uint32_t task_id, uint16_t task_number,
+								dd_callback callback, void *context);
+dd_ticket release_dd_task_at_async(TaskHandle_t t_handle, task_type type, uint32_t task_id, uint16_t task_number,
+								   TickType_t release_time, dd_callback callback, void *context);
+dd_ticket complete_dd_task_async(dd_task task, dd_callback callback, void *context);
+dd_ticket release_dd_chain_async(uint8_t chain_id, dd_callback callback, void *context);
+dd_ticket release_dd_task_batch_async(const job_desc *jobs, size_t n, dd_callback callback, void *context);
+dd_ticket get_dd_stats_async(dd_stats *stats, dd_callback callback, void *context);
+dd_ticket get_dd_histograms_async(uint16_t task_number, dd_histograms *out, dd_callback callback, void *context);
+dd_ticket get_active_tasks_async(dd_task *out, size_t cap, size_t *n, dd_callback callback, void *context);
+dd_ticket get_completed_tasks_async(dd_task *out, size_t cap, uint32_t from_seq, size_t *n,
+									dd_callback callback, void *context);
+dd_ticket get_overdue_tasks_async(dd_task *out, size_t cap, uint32_t from_seq, size_t *n,
+								  dd_callback callback, void *context);
+dd_ticket_state dd_ticket_poll(dd_ticket ticket);
+void dd_ticket_release(dd_ticket ticket);
+void release_dd_chain(uint8_t chain_id);
+void release_dd_task_batch(const job_desc *jobs, size_t n);
+void start_chain(uint8_t chain_id, TickType_t release_time, dd_task_node **active_list, dd_stats *stats);
+void chain_stage_done(dd_task *task, dd_task_node **active_list, dd_stats *stats);
+void release_chain_stages(uint8_t instance, dd_task_node **active_list, dd_stats *stats);
+TickType_t get_stage_deadline(const dd_chain *chain, uint8_t stage);
+int get_stage_execution_time(dd_task *task);
+BaseType_t receive_message(dd_message *message, dd_stats *stats);
+BaseType_t next_message(dd_message *message, uint32_t *completions, dd_stats *stats);
+void assign_job_slot(dd_task *task);
+void free_job_slot(dd_task *task);
 
 void complete_dd_task(dd_task task);
+#if configUSE_CO_ROUTINES
+void release_dd_co_task(task_type type, uint32_t task_id, uint16_t task_number);
+BaseType_t complete_dd_co_task(dd_task task);
+void co_job_ready(dd_task *task);
+void co_dispatcher(CoRoutineHandle_t xHandle, UBaseType_t uxIndex);
+#endif
 dd_task_node *get_active_list(void);
 dd_task_node *get_completed_list(void);
 dd_task_node *get_overdue_list(void);
-
-void generator1_callback(TimerHandle_t xTimer);
-void generator2_callback(TimerHandle_t xTimer);
-void generator3_callback(TimerHandle_t xTimer);
+void get_dd_stats(dd_stats *stats);
+void get_dd_stats_histograms(dd_stats *stats, dd_histograms *histograms);
+void get_active_tasks(dd_task *out, size_t cap, size_t *n);
+void get_completed_tasks(dd_task *out, size_t cap, uint32_t from_seq, size_t *n);
+void get_overdue_tasks(dd_task *out, size_t cap, uint32_t from_seq, size_t *n);
+void get_task_snapshot(message_type type, dd_task *out, size_t cap, uint32_t from_seq, size_t *n);
+void get_dd_histograms(uint16_t task_number, dd_histograms *out);
+uint32_t hist_bucket(uint32_t value);
+uint32_t hist_bucket_limit(uint32_t bucket);
+void hist_add(dd_histogram *histogram, uint32_t value);
+uint32_t hist_percentile(const dd_histogram *histogram, uint32_t per_mille);
+void record_release(dd_task *task);
+void record_completion(dd_task *task);
+uint32_t tick_to_us(TickType_t tick);
+void print_task_summary(uint16_t task_number, const dd_stats *stats, const dd_histograms *histograms);
+void print_cpu_usage(uint32_t released_count);
+void print_trace_names(void);
+void print_queue_stats(const dd_stats *stats);
+void print_stack_headroom(void);
+
+void generator_callback(TimerHandle_t xTimer);
 void monitor_callback(TimerHandle_t xTimer);
+void chain_callback(TimerHandle_t xTimer);
+#if DDS_BENCH
+void dds_bench(void *pvParameters);
+void bench_dummy(void *pvParameters);
+void bench_worker(void *pvParameters);
+void bench_dds_round_trips(TaskHandle_t *dummies, uint32_t *id);
+#endif
 
-xQueueHandle xQueueMessages;
+xQueueHandle xQueueEvents;
+xQueueHandle xQueueQueries;
 xQueueHandle xQueueResponses;
+xQueueHandle xQueueCallbacks;
 
 BaseType_t dd_scheduler_task;
-BaseType_t dd_task_gen1_task;
-BaseType_t dd_task_gen2_task;
-BaseType_t dd_task_gen3_task;
-BaseType_t user_defined_task1;
-BaseType_t user_defined_task2;
-BaseType_t user_defined_task3;
 BaseType_t monitor_task;
 
-TimerHandle_t timer_generator1;
-TimerHandle_t timer_generator2;
-TimerHandle_t timer_generator3;
+TimerHandle_t timer_generators[NUM_TASKS];
+/* Nominal time of each task's next release, advanced by exactly T per release */
+TickType_t next_release[NUM_TASKS];
+#if GENERATOR_TASKS
+/* Nominal release handed from the timer callback to the generator task */
+TickType_t pending_release[NUM_TASKS];
+#endif
+/* Per-task release bookkeeping of generate_release, only touched by the releasing context */
+uint32_t release_count[NUM_TASKS];
+uint32_t last_release_cycles[NUM_TASKS];
+uint8_t last_release_sent[NUM_TASKS]; // last_release_cycles is the previous period's release
+/* Largest deviation of a release interval from the period (us), indexed by task_number */
+uint32_t release_jitter_max[NUM_TASKS + 1];
+/* Releases the DDS never got because the lane or ticket table was full, indexed by task_number */
+uint32_t lost_releases[NUM_TASKS + 1];
 TimerHandle_t timer_monitor;
+TimerHandle_t timer_chain;
+
+/* Task IDs, chain jobs use the task_number 0 range */
+uint32_t CHAIN_ID = 4000;
+
+dd_chain_instance chain_instances[MAX_CHAIN_INSTANCES];
+
+/* Jobs currently holding a completion slot, owned by the DDS. For a worker slot this is also the
+   mailbox the worker reads its job from. */
+dd_task job_slots[MAX_JOB_SLOTS];
+uint32_t free_job_slots = JOB_SLOT_MASK;
+TaskHandle_t pxWorkers[NUM_WORKERS];
+
+/* Per-worker clock behind the task tag, times points at the running job's record */
+typedef struct dd_job_clock
+{
+	dd_job_times *volatile times;
+	uint32_t switched_out_us;
+} dd_job_clock;
+
+dd_job_clock worker_clocks[NUM_WORKERS];
+/* Kernel state of each worker's jobs, and of the co-routine dispatcher's */
+workload_context worker_workloads[NUM_WORKERS];
+workload_context co_workload;
+
+#if configUSE_CO_ROUTINES
+/* Co-routine DD-Tasks. The DDS is the only task that claims FREE entries, the dispatcher is the
+   only one that moves them on, so the volatile state is all the synchronisation needed. */
+#define MAX_CO_JOBS 128
+#define CO_FREE 0
+#define CO_READY 1 // released, filled in by the DDS
+#define CO_DONE 2  // body finished, completion not yet accepted by the DDS
+typedef struct dd_co_job
+{
+	dd_task task;
+	TickType_t remaining; // execution ticks left
+	volatile uint8_t state;
+} dd_co_job;
+
+dd_co_job co_jobs[MAX_CO_JOBS];
+#endif
 
-/* Task IDs */
-uint32_t ID1 = 1000;
-uint32_t ID2 = 2000;
-uint32_t ID3 = 3000;
+/* Kernel object memory for the static build, the create_* helpers take NULL otherwise */
+#if configSUPPORT_STATIC_ALLOCATION
+#define STATIC_BUFFER(buffer) (buffer)
+
+uint8_t events_storage[MESSAGE_QUEUE_SIZE * sizeof(dd_message)];
+uint8_t queries_storage[MESSAGE_QUEUE_SIZE * sizeof(dd_message)];
+uint8_t responses_storage[MESSAGE_QUEUE_SIZE * sizeof(dd_message)];
+uint8_t callbacks_storage[MAX_TICKETS * sizeof(dd_ticket)];
+StaticQueue_t events_queue;
+StaticQueue_t queries_queue;
+StaticQueue_t responses_queue;
+StaticQueue_t callbacks_queue;
+
+StackType_t dds_stack[DDS_STACK_SIZE];
+StackType_t monitor_stack[MONITOR_STACK_SIZE];
+StackType_t callback_service_stack[SERVICE_STACK_SIZE];
+StackType_t log_stack[LOG_STACK_SIZE];
+StackType_t worker_stacks[NUM_WORKERS][WORKER_STACK_SIZE];
+StaticTask_t dds_tcb;
+StaticTask_t monitor_tcb;
+StaticTask_t callback_service_tcb;
+StaticTask_t log_tcb;
+StaticTask_t worker_tcbs[NUM_WORKERS];
+#if GENERATOR_TASKS
+StackType_t generator_stacks[NUM_TASKS][GENERATOR_STACK_SIZE];
+StaticTask_t generator_tcbs[NUM_TASKS];
+#endif
+
+StaticTimer_t generator_timers[NUM_TASKS];
+StaticTimer_t monitor_timer;
+StaticTimer_t chain_timer;
+
+StackType_t idle_stack[configMINIMAL_STACK_SIZE];
+StaticTask_t idle_tcb;
+StackType_t timer_service_stack[configTIMER_TASK_STACK_DEPTH];
+StaticTask_t timer_service_tcb;
+#else
+#define STATIC_BUFFER(buffer) NULL
+#endif
+
+/* Jobs of the release_batch being merged, owned by the DDS and too large for its stack */
+dd_task batch_jobs[MAX_BATCH_SIZE];
+
+/* Outcome histograms and the last release of each task, owned by the DDS */
+dd_histograms task_histograms[NUM_TASKS];
+uint32_t last_release_us[NUM_TASKS];
+/* The monitor's copy, too large for its stack */
+dd_histograms monitor_histograms[NUM_TASKS];
+/* dd_time_us at tick 0, kept by the tick hook. SysTick and the cycle counter run from the same
+   clock, so tick k starts k ms after it. */
+volatile uint32_t tick_epoch_us;
+/* Room for every task myDDS_Init creates plus the kernel's, the bench and F-Tasks */
+#define MAX_TASK_STATUS (NUM_WORKERS + NUM_TASKS + 12)
+TaskStatus_t task_status[MAX_TASK_STATUS];
+
+/* Last sequence number given to a DD-Task leaving the active list */
+uint32_t history_seq = 0;
+
+/* Async request bookkeeping, shared by all senders and the DDS (critical sections) */
+dd_ticket_slot tickets[MAX_TICKETS];
+dd_ticket last_ticket = DD_TICKET_NONE;
+uint32_t rejected_sends[NUM_LANES];
+uint32_t retried_sends[NUM_LANES];
+/* Queue occupancy and blocking, updated by senders and receivers (critical sections) */
+dd_queue_stats queue_stats[NUM_QUEUES];
 
 int hyper_period_complete = 0;
+#if STACK_PROFILE
+int stack_profile_done = 0;
+#endif
+#if TRACE_STREAM
+uint32_t trace_printed = 0;
+#endif
 dd_task_node *active_list_global = NULL;
 dd_task_node *completed_list_global = NULL;
 dd_task_node *overdue_list_global = NULL;
 
 int main(void)
 {
+#if !DDS_BENCH
+	uint32_t i;
+#endif
+
+	console_init(&CONSOLE_DEFAULT_SINK);
 	myDDS_Init();
 	results_Init();
+	workload_calibrate();
+#if PRINT_TEST
+	printf("Workload units per ms: ALU %d, memory %d, FIR %d, matrix %d\n",
+		   (int)workload_units_per_ms(WORKLOAD_ALU), (int)workload_units_per_ms(WORKLOAD_MEMORY),
+		   (int)workload_units_per_ms(WORKLOAD_FIR), (int)workload_units_per_ms(WORKLOAD_MATRIX));
+#endif
 
 	/* Start the tasks and timers*/
-	xTimerStart(timer_generator1, 0);
-	xTimerStart(timer_generator2, 0);
-	xTimerStart(timer_generator3, 0);
+#if DDS_BENCH
+	xTaskCreate(dds_bench, "bench", configMINIMAL_STACK_SIZE * 2, NULL, PRIORITY_MED, NULL);
+#else
+	for (i = 0; i < NUM_TASKS; i++)
+	{
+		// Phase 0 tasks release straight away, the timer handles the rest
+		if (task_table[i].phase == 0)
+		{
+			release_next(i);
+		}
+		if (task_table[i].type == PERIODIC || task_table[i].phase > 0)
+		{
+			xTimerStart(timer_generators[i], 0);
+		}
+	}
+#endif
 	xTimerStart(timer_monitor, 0);
+#if CHAIN_TEST
+	xTimerStart(timer_chain, 0);
+#endif
 	vTaskStartScheduler();
 	while (1)
 	{
@@ -240,42 +851,177 @@ int main(void)
 
 void myDDS_Init()
 {
-	/* Initialize Queue*/
-	xQueueMessages = xQueueCreate(MESSAGE_QUEUE_SIZE, sizeof(dd_message));
-	xQueueResponses = xQueueCreate(MESSAGE_QUEUE_SIZE, sizeof(dd_message));
-	vQueueAddToRegistry(xQueueMessages, "messages");
-	vQueueAddToRegistry(xQueueMessages, "responses");
+	uint32_t i;
+
+	dd_time_init();
+	dd_trace_init();
+#if SRP_POOL
+	// Every relative deadline the test bench uses may need its own nesting level
+	configASSERT(count_relative_deadlines() <= SRP_LEVELS);
+#endif
 
-	if (xQueueMessages == NULL | xQueueResponses == NULL)
+	/* Initialize Queue*/
+	xQueueEvents = create_queue(MESSAGE_QUEUE_SIZE, sizeof(dd_message), STATIC_BUFFER(events_storage), STATIC_BUFFER(&events_queue));
+	xQueueQueries = create_queue(MESSAGE_QUEUE_SIZE, sizeof(dd_message), STATIC_BUFFER(queries_storage), STATIC_BUFFER(&queries_queue));
+	xQueueResponses = create_queue(MESSAGE_QUEUE_SIZE, sizeof(dd_message), STATIC_BUFFER(responses_storage), STATIC_BUFFER(&responses_queue));
+	xQueueCallbacks = create_queue(MAX_TICKETS, sizeof(dd_ticket), STATIC_BUFFER(callbacks_storage), STATIC_BUFFER(&callbacks_queue));
+	vQueueAddToRegistry(xQueueEvents, "events");
+	vQueueAddToRegistry(xQueueQueries, "queries");
+	vQueueAddToRegistry(xQueueResponses, "responses");
+	vQueueAddToRegistry(xQueueCallbacks, "callbacks");
+	// Queue numbers identify the queues in kernel trace events, 0 is any other queue
+	vQueueSetQueueNumber(xQueueEvents, QUEUE_EVENTS + 1);
+	vQueueSetQueueNumber(xQueueQueries, QUEUE_QUERIES + 1);
+	vQueueSetQueueNumber(xQueueResponses, QUEUE_RESPONSES + 1);
+	vQueueSetQueueNumber(xQueueCallbacks, QUEUE_CALLBACKS + 1);
+	queue_stats[QUEUE_EVENTS].capacity = MESSAGE_QUEUE_SIZE;
+	queue_stats[QUEUE_QUERIES].capacity = MESSAGE_QUEUE_SIZE;
+	queue_stats[QUEUE_RESPONSES].capacity = MESSAGE_QUEUE_SIZE;
+	queue_stats[QUEUE_CALLBACKS].capacity = MAX_TICKETS;
+
+	if (xQueueEvents == NULL | xQueueQueries == NULL | xQueueResponses == NULL | xQueueCallbacks == NULL)
 	{
 
 		printf("Error creating queues\n");
 	}
 	/* Initialize Tasks*/
-	dd_scheduler_task = xTaskCreate(dd_scheduler, "dd_scheduler", configMINIMAL_STACK_SIZE, NULL, PRIORITY_HIGH, &pxDDS);
-	monitor_task = xTaskCreate(monitor, "monitor", configMINIMAL_STACK_SIZE, NULL, PRIORITY_HIGH, &pxMonitor);
+	dd_scheduler_task = create_task(dd_scheduler, "dd_scheduler", DDS_STACK_SIZE, NULL, PRIORITY_HIGH, &pxDDS,
+									STATIC_BUFFER(dds_stack), STATIC_BUFFER(&dds_tcb));
+	monitor_task = create_task(monitor, "monitor", MONITOR_STACK_SIZE, NULL, PRIORITY_HIGH, &pxMonitor,
+							   STATIC_BUFFER(monitor_stack), STATIC_BUFFER(&monitor_tcb));
+	create_task(dd_callback_service, "dd_callbk", SERVICE_STACK_SIZE, NULL, PRIORITY_SERVICE, &pxCallbackService,
+				STATIC_BUFFER(callback_service_stack), STATIC_BUFFER(&callback_service_tcb));
+	create_task(dd_log_task, "dd_log", LOG_STACK_SIZE, NULL, PRIORITY_LOG, &pxLog,
+				STATIC_BUFFER(log_stack), STATIC_BUFFER(&log_tcb));
+	// Off the hot path, these wait for the console instead of losing output
+	console_block_writes(pxLog);
+#if TRACE_STREAM || STACK_PROFILE
+	console_block_writes(pxMonitor);
+#endif
+#if configUSE_CO_ROUTINES
+	xCoRoutineCreate(co_dispatcher, 0, 0);
+#endif
 
-	dd_task_gen1_task = xTaskCreate(dd_task_generator_1, "dd_task_gen1", configMINIMAL_STACK_SIZE, NULL, PRIORITY_MED, &pxTaskGen1);
-	dd_task_gen2_task = xTaskCreate(dd_task_generator_2, "dd_task_gen2", configMINIMAL_STACK_SIZE, NULL, PRIORITY_MED, &pxTaskGen2);
-	dd_task_gen3_task = xTaskCreate(dd_task_generator_3, "dd_task_gen3", configMINIMAL_STACK_SIZE, NULL, PRIORITY_MED, &pxTaskGen3);
-	vTaskSuspend(pxTaskGen1);
-	vTaskSuspend(pxTaskGen2);
-	vTaskSuspend(pxTaskGen3);
+	/* Worker pool, every job runs on one of these */
+	configASSERT(NUM_WORKERS + 1 <= WORKLOAD_CONTEXTS);
+	workload_context_init(&co_workload, NUM_WORKERS);
+	for (i = 0; i < NUM_WORKERS; i++)
+	{
+		workload_context_init(&worker_workloads[i], i);
+		if (create_task(dd_worker, "worker", WORKER_STACK_SIZE, (void *)i, PRIORITY_LOW, &pxWorkers[i],
+						STATIC_BUFFER(worker_stacks[i]), STATIC_BUFFER(&worker_tcbs[i])) != pdPASS)
+		{
+			printf("Error creating worker %d\n", (int)i);
+		}
+		vTaskSetApplicationTaskTag(pxWorkers[i], (TaskHookFunction_t)&worker_clocks[i]);
+	}
 
-	if ((dd_scheduler_task == NULL) | (dd_task_gen1_task == NULL) | (dd_task_gen2_task == NULL) | (dd_task_gen3_task == NULL) | (monitor_task == NULL))
+	if ((dd_scheduler_task != pdPASS) | (monitor_task != pdPASS))
 	{
 		printf("Error creating tasks\n");
 	}
 
-	/* Timers for each generator using the period for each task */
-	timer_generator1 = xTimerCreate("timer1", pdMS_TO_TICKS(t1_period), pdTRUE, 0, generator1_callback);
-	timer_generator2 = xTimerCreate("timer2", pdMS_TO_TICKS(t2_period), pdTRUE, 0, generator2_callback);
-	timer_generator3 = xTimerCreate("timer3", pdMS_TO_TICKS(t3_period), pdTRUE, 0, generator3_callback);
+	/* One one-shot timer per task, the timer ID is the task_table index. It first expires at the
+	   phase (or one period after the start-up release) and is re-armed by its callback. */
+	for (i = 0; i < NUM_TASKS; i++)
+	{
+		next_release[i] = xTaskGetTickCount() + pdMS_TO_TICKS(task_table[i].phase);
+#if GENERATOR_TASKS
+		if (create_task(dd_task_generator, "dd_task_gen", GENERATOR_STACK_SIZE, (void *)i, PRIORITY_MED, &pxGenerators[i],
+						STATIC_BUFFER(generator_stacks[i]), STATIC_BUFFER(&generator_tcbs[i])) != pdPASS)
+		{
+			printf("Error creating generator %d\n", (int)i);
+		}
+		vTaskSuspend(pxGenerators[i]);
+#endif
+
+		timer_generators[i] = create_timer("gen_timer",
+										   pdMS_TO_TICKS(task_table[i].phase > 0 ? task_table[i].phase : task_table[i].period),
+										   pdFALSE, (void *)i, generator_callback, STATIC_BUFFER(&generator_timers[i]));
+	}
 
 	/* Monitor timer. */
-	timer_monitor = xTimerCreate("monitor", MONITOR_PERIOD, pdTRUE, 0, monitor_callback);
+	timer_monitor = create_timer("monitor", MONITOR_PERIOD, pdTRUE, 0, monitor_callback, STATIC_BUFFER(&monitor_timer));
+
+	/* Chain timer, only started when CHAIN_TEST is set. */
+	timer_chain = create_timer("chain", CHAIN_PERIOD, pdTRUE, 0, chain_callback, STATIC_BUFFER(&chain_timer));
 };
 
+/* Kernel object creation for myDDS_Init, from the given buffers in the static build and from the
+   FreeRTOS heap otherwise (the buffers are NULL then). */
+BaseType_t create_task(TaskFunction_t code, const char *name, uint16_t stack_depth, void *parameters,
+					   UBaseType_t priority, TaskHandle_t *handle, StackType_t *stack, StaticTask_t *tcb)
+{
+#if configSUPPORT_STATIC_ALLOCATION
+	*handle = xTaskCreateStatic(code, name, stack_depth, parameters, priority, stack, tcb);
+	return (*handle != NULL) ? pdPASS : pdFAIL;
+#else
+	return xTaskCreate(code, name, stack_depth, parameters, priority, handle);
+#endif
+}
+
+QueueHandle_t create_queue(UBaseType_t length, UBaseType_t item_size, uint8_t *storage, StaticQueue_t *buffer)
+{
+#if configSUPPORT_STATIC_ALLOCATION
+	return xQueueCreateStatic(length, item_size, storage, buffer);
+#else
+	return xQueueCreate(length, item_size);
+#endif
+}
+
+TimerHandle_t create_timer(const char *name, TickType_t period, UBaseType_t auto_reload, void *id,
+						   TimerCallbackFunction_t callback, StaticTimer_t *buffer)
+{
+#if configSUPPORT_STATIC_ALLOCATION
+	return xTimerCreateStatic(name, period, auto_reload, id, callback, buffer);
+#else
+	return xTimerCreate(name, period, auto_reload, id, callback);
+#endif
+}
+
+/* Adds a relative deadline to the first count entries of seen unless it is there already. */
+uint32_t add_deadline(TickType_t *seen, uint32_t count, TickType_t deadline)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (seen[i] == deadline)
+		{
+			return count;
+		}
+	}
+	seen[count] = deadline;
+	return count + 1;
+}
+
+/* Number of distinct relative deadlines among the jobs the test bench releases: the task_table
+   entries and, with CHAIN_TEST, the chain stages. */
+uint32_t count_relative_deadlines(void)
+{
+	TickType_t seen[NUM_TASKS + NUM_CHAINS * MAX_CHAIN_STAGES];
+	uint32_t count = 0;
+	uint32_t i;
+#if CHAIN_TEST
+	uint8_t stage;
+#endif
+
+	for (i = 0; i < NUM_TASKS; i++)
+	{
+		count = add_deadline(seen, count, pdMS_TO_TICKS(task_table[i].deadline));
+	}
+#if CHAIN_TEST
+	for (i = 0; i < NUM_CHAINS; i++)
+	{
+		for (stage = 0; stage < chains[i].num_stages; stage++)
+		{
+			count = add_deadline(seen, count, get_stage_deadline(&chains[i], stage));
+		}
+	}
+#endif
+	return count;
+}
+
 void results_Init()
 {
 	printf("+-------------------------------------------------------+\n");
@@ -289,26 +1035,36 @@ void dd_scheduler(void *pvParameters)
 	dd_task_node *active_list = NULL;
 	dd_task_node *completed_list = NULL;
 	dd_task_node *overdue_list = NULL;
+	dd_stats stats = {0};
 
 	dd_message message;
 	dd_task task;
+	size_t i;
 	TickType_t currTick;
 	TickType_t measured_time;
-	int period;
+	uint32_t completions;
+	int found;
+	TickType_t deadline;
 	int event_number = 1;
 
 	while (1)
 	{
-		if (xQueueReceive(xQueueMessages, &message, portMAX_DELAY))
+		// Sleep until a sender rings the doorbell or a job signals completion
+		xTaskNotifyWait(0, 0xFFFFFFFFUL, &completions, portMAX_DELAY);
+		completions &= JOB_SLOT_MASK;
+
+		// Drain everything that is pending: completions, then events, then queries
+		while (next_message(&message, &completions, &stats))
 		{
 			dd_task_node **active_list_head = &active_list;
 			dd_task_node **completed_list_head = &completed_list;
+			dd_task_node **overdue_list_head = &overdue_list;
 
 			// checks if any tasks are overdue, if they are move them to the overdue_list and remove from active list
-			move_overdue_tasks(active_list, overdue_list);
+			move_overdue_tasks(active_list_head, overdue_list_head, &stats);
 			// sort list after checking overdue tasks
 			sort_EDF(active_list_head);
-			period = get_period_TICKS(message.task.task_number);
+			deadline = get_deadline_TICKS(message.task.task_number);
 
 			switch (message.type)
 			{
@@ -318,12 +1074,70 @@ void dd_scheduler(void *pvParameters)
 
 				print_event(event_number, message.task.task_number, message.type, measured_time);
 				event_number++;
-				message.task.release_time = currTick;
-				message.task.absolute_deadline = currTick + period;
+				// Release time comes from the sender, deadlines follow the nominal release
+				message.task.absolute_deadline = message.task.release_time + deadline;
+#if configUSE_CO_ROUTINES
+				if (message.task.slot == CO_SLOT)
+				{
+					co_job_ready(&message.task);
+				}
+				else
+#endif
+				{
+					assign_job_slot(&message.task);
+				}
+				dd_trace(TRACE_RELEASE, message.task.task_id, message.task.task_number, message.task.slot);
+				record_release(&message.task);
 
 				insert_at_back(active_list_head, message.task);
 				sort_EDF(active_list_head);
-				set_priority(active_list_head);
+
+				stats.released_count++;
+				stats.active_count++;
+				stats.utilisation += get_utilisation(message.task.task_number);
+				break;
+
+			case release_batch:
+				currTick = xTaskGetTickCount();
+				measured_time = currTick * portTICK_PERIOD_MS;
+
+				for (i = 0; i < message.num_jobs; i++)
+				{
+					batch_jobs[i].t_handle = message.jobs[i].t_handle;
+					batch_jobs[i].type = message.jobs[i].type;
+					batch_jobs[i].task_id = message.jobs[i].task_id;
+					batch_jobs[i].task_number = message.jobs[i].task_number;
+					batch_jobs[i].release_time = message.sent_time;
+					batch_jobs[i].absolute_deadline = message.sent_time + get_deadline_TICKS(batch_jobs[i].task_number);
+					batch_jobs[i].completion_time = 0;
+					batch_jobs[i].chain = NO_CHAIN;
+					batch_jobs[i].stage = 0;
+					batch_jobs[i].seq = 0;
+					stamp_release(&batch_jobs[i].times);
+					assign_job_slot(&batch_jobs[i]);
+					dd_trace(TRACE_RELEASE, batch_jobs[i].task_id, batch_jobs[i].task_number, batch_jobs[i].slot);
+					record_release(&batch_jobs[i]);
+
+					print_event(event_number, batch_jobs[i].task_number, release, measured_time);
+					event_number++;
+					stats.released_count++;
+					stats.active_count++;
+					stats.utilisation += get_utilisation(batch_jobs[i].task_number);
+				}
+
+				// One merge pass for the whole batch, dispatch happens once the lanes are drained
+				insert_batch_EDF(active_list_head, batch_jobs, message.num_jobs);
+
+				// The job descriptors belong to the sender, let it continue
+				if (message.ticket == DD_TICKET_NONE)
+				{
+					xTaskNotifyGive(message.sender);
+				}
+				break;
+
+			case release_chain:
+				start_chain(message.task.chain, message.task.release_time, active_list_head, &stats);
+				sort_EDF(active_list_head);
 				break;
 
 			case complete:
@@ -332,8 +1146,39 @@ void dd_scheduler(void *pvParameters)
 
 				print_event(event_number, message.task.task_number, message.type, measured_time);
 				event_number++;
-				task = pop(active_list_head);
-				insert_at_back(completed_list_head, task);
+
+				// The removed node holds the slot the DDS assigned, a queued completion only carries
+				// NO_SLOT. A job already moved to the overdue list still frees its worker, whose slot
+				// the completion message was read from.
+				found = remove_node_by_task_id(active_list_head, message.task.task_id, &task);
+				free_job_slot(found ? &task : &message.task);
+				record_completion(&message.task);
+				if (!found)
+				{
+					break;
+				}
+				task.completion_time = currTick;
+				task.seq = ++history_seq;
+				stats.active_count--;
+				stats.utilisation -= get_utilisation(task.task_number);
+
+				if (task.completion_time <= task.absolute_deadline)
+				{
+					insert_at_back(completed_list_head, task);
+					stats.completed_count++;
+				}
+				else
+				{
+					insert_at_back(overdue_list_head, task);
+					record_overdue(&task, &stats);
+				}
+
+				// Completing a chain stage may release its successors
+				if (task.chain != NO_CHAIN)
+				{
+					chain_stage_done(&task, active_list_head, &stats);
+				}
+
 				if (*active_list_head != NULL)
 				{
 					sort_EDF(active_list_head);
@@ -342,151 +1187,354 @@ void dd_scheduler(void *pvParameters)
 				break;
 
 			case get_active:
-				xQueueSendToBack(xQueueResponses, &active_list, portMAX_DELAY);
+				queue_send(QUEUE_RESPONSES, xQueueResponses, &active_list, portMAX_DELAY);
 				break;
 
 			case get_completed:
-				xQueueSendToBack(xQueueResponses, &completed_list, portMAX_DELAY);
+				queue_send(QUEUE_RESPONSES, xQueueResponses, &completed_list, portMAX_DELAY);
 				break;
 
 			case get_overdue:
-				xQueueSendToBack(xQueueResponses, &overdue_list, portMAX_DELAY);
+				queue_send(QUEUE_RESPONSES, xQueueResponses, &overdue_list, portMAX_DELAY);
+				break;
+
+			case get_stats:
+				taskENTER_CRITICAL();
+				for (i = 0; i < NUM_LANES; i++)
+				{
+					stats.rejected_sends[i] = rejected_sends[i];
+					stats.retried_sends[i] = retried_sends[i];
+				}
+				for (i = 0; i < NUM_QUEUES; i++)
+				{
+					stats.queues[i] = queue_stats[i];
+				}
+				for (i = 0; i <= NUM_TASKS; i++)
+				{
+					stats.lost_releases[i] = lost_releases[i];
+				}
+				taskEXIT_CRITICAL();
+				*message.stats = stats;
+				if (message.histograms != NULL)
+				{
+					for (i = 0; i < NUM_TASKS; i++)
+					{
+						message.histograms[i] = task_histograms[i];
+					}
+				}
+				reply_to_sender(&message);
+				break;
+
+			case snapshot_active:
+				*message.count = copy_task_list(active_list, message.snapshot, message.capacity, 0);
+				reply_to_sender(&message);
+				break;
+
+			case snapshot_completed:
+				*message.count = copy_task_list(completed_list, message.snapshot, message.capacity, message.from_seq);
+				reply_to_sender(&message);
+				break;
+
+			case snapshot_overdue:
+				*message.count = copy_task_list(overdue_list, message.snapshot, message.capacity, message.from_seq);
+				reply_to_sender(&message);
+				break;
+
+			case get_histograms:
+				if (message.task.task_number >= 1 && message.task.task_number <= NUM_TASKS)
+				{
+					*message.histograms = task_histograms[message.task.task_number - 1];
+				}
+				reply_to_sender(&message);
 				break;
 
 			default:
 				break;
 			}
+
+			// Async releases/completions are done once processed, queries are answered above
+			if (message.ticket != DD_TICKET_NONE && get_lane(message.type) == LANE_EVENTS)
+			{
+				complete_ticket(message.ticket);
+			}
 		}
 
+		// One dispatch decision per drain: hand out idle workers, then raise the head job
 		if (active_list != NULL)
 		{
-			vTaskResume(active_list->task.t_handle);
+			assign_workers(active_list);
+			set_priority(&active_list);
+			if (active_list->task.t_handle != NULL)
+			{
+				vTaskResume(active_list->task.t_handle);
+			}
 		}
 	}
 };
 void monitor(void *pvParameters)
 {
-	dd_task_node *active_list;
-	dd_task_node *completed_list;
-	dd_task_node *overdue_list;
-
-	int active_count = 0;
-	int completed_count = 0;
-	int overdue_count = 0;
+	dd_stats stats;
+	int i;
 
 	while (1)
 	{
-		active_list = get_active_list();
-		completed_list = get_completed_list();
-		overdue_list = get_overdue_list();
-
-		active_count = get_list_count(active_list);
-		completed_count = get_list_count(completed_list);
-		overdue_count = get_list_count(overdue_list);
-
-		printf("MONITOR TASK:\n");
-		printf("Number of active DD-Tasks: %d\n", active_count);
-		printf("Number of completed DD-Tasks: %d\n", completed_count);
-		printf("Number of overdue DD-Tasks: %d\n", overdue_count);
-		printf("\n\n\n");
+		get_dd_stats_histograms(&stats, monitor_histograms);
+
+		DD_LOG("MONITOR TASK:\n");
+		DD_LOG("Number of active DD-Tasks: %d\n", (int)stats.active_count);
+		DD_LOG("Number of completed DD-Tasks: %d\n", (int)stats.completed_count);
+		DD_LOG("Number of overdue DD-Tasks: %d\n", (int)stats.overdue_count);
+		DD_LOG("Number of released DD-Tasks: %d\n", (int)stats.released_count);
+		for (i = 1; i <= NUM_TASKS; i++)
+		{
+			print_task_summary(i, &stats, &monitor_histograms[i - 1]);
+		}
+		DD_LOG("Max lateness (ms): %d\n", (int)(stats.max_lateness * portTICK_PERIOD_MS));
+		DD_LOG("Utilisation (per-mille): %d\n", (int)stats.utilisation);
+		print_cpu_usage(stats.released_count);
+		DD_LOG("Log messages dropped: %d, console bytes dropped: %d\n", (int)dd_log_dropped(), (int)console_dropped());
+		for (i = 0; i < NUM_LANES; i++)
+		{
+			DD_LOG("Lane %d: %d msgs, avg latency (us): %d, max latency (us): %d\n", i,
+				   (int)stats.lane_messages[i],
+				   stats.lane_messages[i] ? (int)(stats.lane_latency_total_us[i] / stats.lane_messages[i]) : 0,
+				   (int)stats.lane_latency_max_us[i]);
+			DD_LOG("Lane %d: %d rejected sends, %d retried sends\n", i,
+				   (int)stats.rejected_sends[i], (int)stats.retried_sends[i]);
+		}
+		print_queue_stats(&stats);
+		print_stack_headroom();
+		DD_LOG("\n\n\n");
+#if TRACE_STREAM
+		if (trace_printed == 0)
+		{
+			print_trace_names();
+		}
+		trace_printed = dd_trace_print(trace_printed);
+#endif
+#if STACK_PROFILE
+		if (!stack_profile_done && xTaskGetTickCount() >= HYPER_PERIOD)
+		{
+			print_stack_profile();
+			stack_profile_done = 1;
+		}
+#endif
 
 		vTaskSuspend(NULL);
 	};
 };
-void dd_task_generator_1(void *pvParameters)
-{
-	TaskHandle_t pxUser1;
 
-	while (1)
+/*
+Prints the peak stack use of each DDS task as stack depth defines for APPLY_STACK_PROFILE. Stacks
+are filled with a known pattern when a task is created and the high water mark is the least free
+space ever seen, so one sample after a hyperperiod covers every job run so far. Workers and
+generators share one depth, so the busiest of them sets it. Interrupts run on the main stack and
+do not count against any task.
+*/
+void print_stack_profile(void)
+{
+	UBaseType_t free;
+	UBaseType_t least_free;
+	uint32_t i;
+
+	printf("STACK PROFILE (after %d ms):\n", (int)(xTaskGetTickCount() * portTICK_PERIOD_MS));
+	print_stack_depth("DDS_STACK_SIZE", DDS_STACK_SIZE, uxTaskGetStackHighWaterMark(pxDDS));
+	print_stack_depth("MONITOR_STACK_SIZE", MONITOR_STACK_SIZE, uxTaskGetStackHighWaterMark(NULL));
+	print_stack_depth("SERVICE_STACK_SIZE", SERVICE_STACK_SIZE, uxTaskGetStackHighWaterMark(pxCallbackService));
+	print_stack_depth("LOG_STACK_SIZE", LOG_STACK_SIZE, uxTaskGetStackHighWaterMark(pxLog));
+
+	least_free = WORKER_STACK_SIZE;
+	for (i = 0; i < NUM_WORKERS; i++)
 	{
-		user_defined_task1 = xTaskCreate(user_defined, "usr_d1", configMINIMAL_STACK_SIZE, NULL, PRIORITY_MED, &pxUser1);
-		vTaskSuspend(pxUser1);
-		release_dd_task(pxUser1, PERIODIC, ++ID1, 1);
-		vTaskSuspend(pxTaskGen1);
+		free = uxTaskGetStackHighWaterMark(pxWorkers[i]);
+		if (free < least_free)
+		{
+			least_free = free;
+		}
 	}
-};
+	print_stack_depth("WORKER_STACK_SIZE", WORKER_STACK_SIZE, least_free);
 
-void dd_task_generator_2(void *pvParameters)
-{
-	TaskHandle_t pxUser2;
-	while (1)
+#if GENERATOR_TASKS
+	least_free = GENERATOR_STACK_SIZE;
+	for (i = 0; i < NUM_TASKS; i++)
 	{
-		user_defined_task2 = xTaskCreate(user_defined, "usr_d2", configMINIMAL_STACK_SIZE, NULL, PRIORITY_MED, &pxUser2);
-		vTaskSuspend(pxUser2);
-		release_dd_task(pxUser2, PERIODIC, ++ID2, 2);
-		vTaskSuspend(pxTaskGen2);
+		free = uxTaskGetStackHighWaterMark(pxGenerators[i]);
+		if (free < least_free)
+		{
+			least_free = free;
+		}
 	}
-};
-void dd_task_generator_3(void *pvParameters)
+	print_stack_depth("GENERATOR_STACK_SIZE", GENERATOR_STACK_SIZE, least_free);
+#endif
+
+	// Kernel tasks, these depths are set in FreeRTOSConfig.h
+	print_stack_depth("configTIMER_TASK_STACK_DEPTH", configTIMER_TASK_STACK_DEPTH,
+					  uxTaskGetStackHighWaterMark(xTimerGetTimerDaemonTaskHandle()));
+	print_stack_depth("idle (configMINIMAL_STACK_SIZE)", configMINIMAL_STACK_SIZE,
+					  uxTaskGetStackHighWaterMark(xTaskGetIdleTaskHandle()));
+	printf("\n");
+}
+
+void print_stack_depth(const char *name, uint32_t depth, UBaseType_t free)
 {
-	TaskHandle_t pxUser3;
+	uint32_t used = depth - free;
+
+	printf("#define %s %d // %d of %d words used\n", name,
+		   (int)((used + STACK_MARGIN + 7) / 8 * 8), (int)used, (int)depth);
+}
+#if GENERATOR_TASKS
+/* Generic generator, pvParameters is the task_table index. Resumed by its timer. */
+void dd_task_generator(void *pvParameters)
+{
+	uint32_t index = (uint32_t)pvParameters;
+
 	while (1)
 	{
-		user_defined_task3 = xTaskCreate(user_defined, "usr_d3", configMINIMAL_STACK_SIZE, NULL, PRIORITY_MED, &pxUser3);
-		release_dd_task(pxUser3, PERIODIC, ++ID3, 3);
-		vTaskSuspend(pxUser3);
-		vTaskSuspend(pxTaskGen3);
+		generate_release(index, pending_release[index]);
+		vTaskSuspend(NULL);
 	}
 };
+#endif
 
-void user_defined(void *pvParameters)
+/* Takes the task's next nominal release and advances the schedule by one period. */
+void release_next(uint32_t index)
 {
-	dd_task_node *activeList;
-	dd_task activeTask;
-	uint16_t task_num;
-	uint16_t count;
-	TickType_t currTick;
-	TickType_t prevTick;
-	TickType_t executionTick;
-	dd_message message;
-	while (1)
-	{
-		activeList = get_active_list();
-		activeTask = activeList->task;
-		task_num = activeTask.task_number;
-		count = 0;
+	TickType_t nominal = dd_release_advance(&next_release[index], pdMS_TO_TICKS(task_table[index].period));
 
-		switch (task_num)
-		{
-		case 1:
-			executionTick = pdMS_TO_TICKS(t1_execution);
-			break;
-		case 2:
-			executionTick = pdMS_TO_TICKS(t2_execution);
-			break;
-		case 3:
-			executionTick = pdMS_TO_TICKS(t3_execution);
-			break;
-		default:
-			printf("ERROR: could not get task number in user defined task.\n");
-			break;
-		}
+#if GENERATOR_TASKS
+	pending_release[index] = nominal;
+	vTaskResume(pxGenerators[index]);
+#else
+	generate_release(index, nominal);
+#endif
+}
 
-		currTick = xTaskGetTickCount();
-		prevTick = currTick;
+/*
+Releases a job of task_table[index] with the given nominal release time. Runs in the timer service
+task, so it must not block: the release goes out as an async request whose ticket is dropped
+straight away, a full lane or ticket table shows up as a rejected send. Such a release is lost: it
+is counted in lost_releases, does not use up a task ID, and the intervals on either side of it are
+left out of the release jitter of the task.
+*/
+void generate_release(uint32_t index, TickType_t nominal)
+{
+	uint16_t task_number = index + 1;
+	uint32_t now = dd_cycles();
+	uint32_t expected;
+	uint32_t deviation;
+	dd_ticket ticket;
+
+	// No handle, the DDS gives the job a worker from the pool
+	ticket = release_dd_task_at_async(NULL, task_table[index].type, task_number * TASK_ID_STRIDE + release_count[index] + 1,
+									  task_number, nominal, NULL, NULL);
+	if (ticket == DD_TICKET_NONE)
+	{
+		lost_releases[task_number]++;
+		last_release_sent[index] = 0;
+		return;
+	}
+	dd_ticket_release(ticket);
+	release_count[index]++;
 
-		// Will exit once task is complete
-		while (count < executionTick)
-		{
-			currTick = xTaskGetTickCount();
-			if (currTick != prevTick)
-			{
-				count++;
-				prevTick = currTick;
-			}
-		}
-		if (activeTask.task_id > 1000 && activeTask.task_id < 4000)
-		{
-			complete_dd_task(activeTask);
-			vTaskDelete(NULL);
-		}
-		else
+	// Intervals between releases of consecutive periods should be exactly one period
+	if (last_release_sent[index])
+	{
+		expected = (uint32_t)task_table[index].period * DD_CYCLES_PER_US * 1000;
+		deviation = now - last_release_cycles[index];
+		deviation = (deviation > expected) ? deviation - expected : expected - deviation;
+		if (deviation / DD_CYCLES_PER_US > release_jitter_max[task_number])
 		{
-			printf("error: cannot complete task in user defined. NO valid task id\n");
+			release_jitter_max[task_number] = deviation / DD_CYCLES_PER_US;
 		}
 	}
+	last_release_cycles[index] = now;
+	last_release_sent[index] = 1;
+}
+
+/* Job body, does the DD-Task's execution time worth of CPU work with its calibrated kernel. Time
+   spent preempted does not count towards it. */
+void user_defined(dd_task *job)
+{
+	int execution_ms;
+
+	if (job->task_number == CHAIN_TASK_NUMBER)
+	{
+		execution_ms = get_stage_execution_time(job);
+	}
+	else
+	{
+		execution_ms = get_execution_time(job->task_number);
+	}
+
+	// Pool jobs run in the slot of their worker
+	workload_run(&worker_workloads[job->slot], get_task_workload(job->task_number), (uint32_t)execution_ms * 1000);
+};
+
+/*
+Pool worker. Waits for the DDS to put a job in its slot, runs it and completes it through the
+slot's notification bit. The DDS returns the worker to the pool when it processes the completion.
+*/
+void dd_worker(void *pvParameters)
+{
+	uint32_t index = (uint32_t)pvParameters;
+	dd_task job;
+
+	while (1)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		job = job_slots[index];
+
+		job.times.start_us = dd_time_us();
+		dd_trace(TRACE_DISPATCH, job.task_id, job.task_number, index);
+		worker_clocks[index].switched_out_us = 0;
+		worker_clocks[index].times = &job.times;
+		get_task_body(job.task_number)(&job);
+		worker_clocks[index].times = NULL;
+		complete_dd_task(job);
+	}
 };
 
+/*
+Kernel trace hooks (traceTASK_SWITCHED_OUT/IN) for tagged tasks, run inside the context switch. A
+worker switched out while its job is running has been preempted, the time until it is switched back
+in is added to the job. The job itself is still in the worker's slot while times is set.
+*/
+void dd_job_switched_out(void *tag)
+{
+	dd_job_clock *clock = (dd_job_clock *)tag;
+	uint8_t worker = clock - worker_clocks;
+
+	if (clock->times != NULL)
+	{
+		clock->switched_out_us = dd_time_us();
+		dd_trace(TRACE_PREEMPT, job_slots[worker].task_id, job_slots[worker].task_number, worker);
+	}
+}
+
+void dd_job_switched_in(void *tag)
+{
+	dd_job_clock *clock = (dd_job_clock *)tag;
+	uint8_t worker = clock - worker_clocks;
+
+	if (clock->times != NULL && clock->switched_out_us != 0)
+	{
+		dd_trace(TRACE_RESUME, job_slots[worker].task_id, job_slots[worker].task_number, worker);
+		clock->times->preempted_us += dd_time_us() - clock->switched_out_us;
+		clock->times->preemptions++;
+		clock->switched_out_us = 0;
+	}
+}
+
+/* Fresh timing record for a job that is being released. */
+void stamp_release(dd_job_times *times)
+{
+	times->release_us = dd_time_us();
+	times->start_us = 0;
+	times->completion_us = 0;
+	times->preempted_us = 0;
+	times->preemptions = 0;
+}
+
 /* Core Functionality */
 
 /*
@@ -502,13 +1550,19 @@ void release_dd_task(TaskHandle_t t_handle, task_type type, uint32_t task_id, ui
 	new_task.type = type;
 	new_task.task_id = task_id;
 	new_task.task_number = task_number;
+	new_task.release_time = xTaskGetTickCount();
+	new_task.chain = NO_CHAIN;
+	new_task.stage = 0;
+	new_task.slot = NO_SLOT;
+	new_task.seq = 0;
+	stamp_release(&new_task.times);
 
 	dd_message new_message;
 	new_message.type = release;
 	new_message.task = new_task;
 	new_message.list = NULL;
 
-	xQueueSendToBack(xQueueMessages, &new_message, portMAX_DELAY);
+	send_to_dds(&new_message);
 }
 
 /*
@@ -517,13 +1571,128 @@ as a message and sent to a queue for the DDS to receive.
 */
 void complete_dd_task(dd_task task)
 {
+	task.times.completion_us = dd_time_us();
+	dd_trace(TRACE_COMPLETE, task.task_id, task.task_number, task.slot);
+
+	// Jobs holding a slot signal the DDS directly, the DDS picks the job up from the slot
+	if (task.slot < MAX_JOB_SLOTS)
+	{
+		job_slots[task.slot].times = task.times;
+		xTaskNotify(pxDDS, 1UL << task.slot, eSetBits);
+		return;
+	}
+
 	dd_message new_message;
 	new_message.type = complete;
 	new_message.task = task;
 
-	xQueueSendToBack(xQueueMessages, &new_message, portMAX_DELAY);
+	send_to_dds(&new_message);
 };
 
+#if configUSE_CO_ROUTINES
+/* Releases a DD-Task that runs on the co-routine pool instead of an F-Task. */
+void release_dd_co_task(task_type type, uint32_t task_id, uint16_t task_number)
+{
+	dd_message new_message;
+	new_message.type = release;
+	new_message.task.t_handle = NULL;
+	new_message.task.type = type;
+	new_message.task.task_id = task_id;
+	new_message.task.task_number = task_number;
+	new_message.task.release_time = xTaskGetTickCount();
+	new_message.task.chain = NO_CHAIN;
+	new_message.task.stage = 0;
+	new_message.task.slot = CO_SLOT;
+	new_message.task.seq = 0;
+	stamp_release(&new_message.task.times);
+	new_message.list = NULL;
+
+	send_to_dds(&new_message);
+}
+
+/* Called from the dispatcher co-routine (idle task), so it must not block. */
+BaseType_t complete_dd_co_task(dd_task task)
+{
+	dd_ticket ticket = complete_dd_task_async(task, NULL, NULL);
+
+	if (ticket == DD_TICKET_NONE)
+	{
+		return pdFAIL;
+	}
+	dd_ticket_release(ticket);
+	return pdPASS;
+}
+
+/* Called by the DDS on release. A full pool leaves the job unstarted, it will show up as overdue. */
+void co_job_ready(dd_task *task)
+{
+	int i;
+
+	for (i = 0; i < MAX_CO_JOBS; i++)
+	{
+		if (co_jobs[i].state == CO_FREE)
+		{
+			co_jobs[i].task = *task;
+			co_jobs[i].remaining = pdMS_TO_TICKS(get_execution_time(task->task_number));
+			co_jobs[i].state = CO_READY;
+			return;
+		}
+	}
+	DD_LOG("Co-routine pool full, DD-Task %d not started\n", (int)task->task_id);
+}
+
+/*
+Runs co-routine DD-Tasks, earliest deadline first, one tick of work per slice. A finished job is
+completed before anything else is picked, and retried on the next slice if the event lane is full.
+Nothing is kept in locals across a yield, as co-routine stacks are not preserved.
+*/
+void co_dispatcher(CoRoutineHandle_t xHandle, UBaseType_t uxIndex)
+{
+	dd_co_job *job;
+	int i;
+
+	crSTART(xHandle);
+
+	for (;;)
+	{
+		job = NULL;
+		for (i = 0; i < MAX_CO_JOBS; i++)
+		{
+			if (co_jobs[i].state == CO_DONE)
+			{
+				job = &co_jobs[i];
+				break;
+			}
+			if (co_jobs[i].state == CO_READY &&
+				(job == NULL || co_jobs[i].task.absolute_deadline < job->task.absolute_deadline))
+			{
+				job = &co_jobs[i];
+			}
+		}
+
+		if (job != NULL && job->state == CO_READY && job->remaining > 0)
+		{
+			// One tick's worth of the task's calibrated kernel, time spent preempted does not count
+			workload_run(&co_workload, get_task_workload(job->task.task_number), portTICK_PERIOD_MS * 1000);
+			job->remaining--;
+		}
+		if (job != NULL && (job->state == CO_DONE || job->remaining == 0))
+		{
+			job->state = CO_DONE;
+			if (complete_dd_co_task(job->task) == pdPASS)
+			{
+				job->state = CO_FREE;
+			}
+		}
+
+		// Nothing to run, sleep until the next tick
+		crDELAY(xHandle, (job == NULL) ? 1 : 0);
+	}
+
+	crEND();
+}
+#endif
+
 /*
 This function sends a message to a queue requesting the Active Task List from the DDS. Once a
 response is received from the DDS, the function returns the list.
@@ -535,10 +1704,10 @@ dd_task_node *get_active_list()
 	message.list = NULL;
 
 	// Send 'get_active' message to DDS
-	xQueueSendToBack(xQueueMessages, &message, portMAX_DELAY);
+	send_to_dds(&message);
 
 	// Wait for reponse from DDS then return active list
-	xQueueReceive(xQueueResponses, &active_list_global, portMAX_DELAY);
+	queue_receive(QUEUE_RESPONSES, xQueueResponses, &active_list_global, portMAX_DELAY);
 	return active_list_global;
 }
 
@@ -553,10 +1722,10 @@ dd_task_node *get_completed_list()
 	message.type = get_completed;
 
 	// Send 'get_active' message to DDS
-	xQueueSendToBack(xQueueMessages, &message, portMAX_DELAY);
+	send_to_dds(&message);
 
 	// Wait for reponse from DDS then return completed list
-	xQueueReceive(xQueueResponses, &completed_list_global, portMAX_DELAY);
+	queue_receive(QUEUE_RESPONSES, xQueueResponses, &completed_list_global, portMAX_DELAY);
 	return completed_list_global;
 };
 
@@ -571,150 +1740,1638 @@ dd_task_node *get_overdue_list()
 	message.type = get_overdue;
 
 	// Send 'get_active' message to DDS
-	xQueueSendToBack(xQueueMessages, &message, portMAX_DELAY);
+	send_to_dds(&message);
 
 	// Wait for reponse from DDS then return overdue list
-	xQueueReceive(xQueueResponses, &overdue_list_global, portMAX_DELAY);
+	queue_receive(QUEUE_RESPONSES, xQueueResponses, &overdue_list_global, portMAX_DELAY);
 	return overdue_list_global;
 };
 
-TickType_t get_period_TICKS(uint16_t task_number)
+/*
+This function sends a message to a queue requesting the scheduler statistics. The DDS copies its
+counters into the caller's struct and then acknowledges on the response queue.
+*/
+void get_dd_stats(dd_stats *stats)
 {
+	get_dd_stats_histograms(stats, NULL);
+}
 
-	if (task_number == 1)
-	{
-		return pdMS_TO_TICKS(t1_period);
-	}
-	else if (task_number == 2)
-	{
-		return pdMS_TO_TICKS(t2_period);
-	}
-	else if (task_number == 3)
-	{
-		return pdMS_TO_TICKS(t3_period);
-	}
-	else
-		return pdMS_TO_TICKS(100);
+/* Like get_dd_stats, and copies the histograms of all tasks into histograms[NUM_TASKS] in the same reply. */
+void get_dd_stats_histograms(dd_stats *stats, dd_histograms *histograms)
+{
+	dd_message message;
+	message.type = get_stats;
+	message.list = NULL;
+	message.stats = stats;
+	message.histograms = histograms;
+
+	send_to_dds(&message);
+
+	// Wait for the DDS to fill in the stats
+	queue_receive(QUEUE_RESPONSES, xQueueResponses, &message, portMAX_DELAY);
 }
 
-int get_execution_time(uint16_t task_number)
+/*
+These functions copy up to cap DD-Tasks of a list into out and store the number copied in n. For
+the completed and overdue lists only DD-Tasks with seq >= from_seq are copied.
+*/
+void get_active_tasks(dd_task *out, size_t cap, size_t *n)
 {
+	get_task_snapshot(snapshot_active, out, cap, 0, n);
+}
 
-	if (task_number == 1)
-	{
-		return t1_execution;
-	}
-	else if (task_number == 2)
+void get_completed_tasks(dd_task *out, size_t cap, uint32_t from_seq, size_t *n)
+{
+	get_task_snapshot(snapshot_completed, out, cap, from_seq, n);
+}
+
+void get_overdue_tasks(dd_task *out, size_t cap, uint32_t from_seq, size_t *n)
+{
+	get_task_snapshot(snapshot_overdue, out, cap, from_seq, n);
+}
+
+void get_task_snapshot(message_type type, dd_task *out, size_t cap, uint32_t from_seq, size_t *n)
+{
+	dd_message message;
+	message.type = type;
+	message.list = NULL;
+	message.snapshot = out;
+	message.capacity = cap;
+	message.from_seq = from_seq;
+	message.count = n;
+
+	send_to_dds(&message);
+
+	// Wait for the DDS to fill in the snapshot
+	queue_receive(QUEUE_RESPONSES, xQueueResponses, &message, portMAX_DELAY);
+}
+
+/* Copies the outcome histograms of one task (1..NUM_TASKS), out is left untouched for others. */
+void get_dd_histograms(uint16_t task_number, dd_histograms *out)
+{
+	dd_message message;
+	message.type = get_histograms;
+	message.list = NULL;
+	message.task.task_number = task_number;
+	message.histograms = out;
+
+	send_to_dds(&message);
+
+	// Wait for the DDS to fill in the histograms
+	queue_receive(QUEUE_RESPONSES, xQueueResponses, &message, portMAX_DELAY);
+}
+
+/*
+This function releases a set of DD-Tasks as one message per MAX_BATCH_SIZE jobs. It blocks until
+the DDS has consumed each message, since the DDS reads the job descriptors in place.
+*/
+void release_dd_task_batch(const job_desc *jobs, size_t n)
+{
+	dd_message new_message;
+	size_t chunk;
+
+	new_message.type = release_batch;
+	new_message.list = NULL;
+	new_message.sender = xTaskGetCurrentTaskHandle();
+
+	while (n > 0)
 	{
-		return t2_execution;
+		chunk = n < MAX_BATCH_SIZE ? n : MAX_BATCH_SIZE;
+		new_message.jobs = jobs;
+		new_message.num_jobs = chunk;
+
+		send_to_dds(&new_message);
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		jobs += chunk;
+		n -= chunk;
 	}
-	else if (task_number == 3)
+}
+
+/*
+This function releases one instance of the chain chains[chain_id]. The DDS releases the stages
+itself as their predecessors complete. The release time is taken here, not when the DDS gets to
+the message, so stage deadlines do not drift with the lane backlog.
+*/
+void release_dd_chain(uint8_t chain_id)
+{
+	dd_message new_message;
+	new_message.type = release_chain;
+	new_message.task.chain = chain_id;
+	new_message.task.release_time = xTaskGetTickCount();
+	new_message.list = NULL;
+
+	send_to_dds(&new_message);
+}
+
+/* Chain bookkeeping, only called from the DDS. */
+void start_chain(uint8_t chain_id, TickType_t release_time, dd_task_node **active_list, dd_stats *stats)
+{
+	uint8_t i;
+
+	for (i = 0; i < MAX_CHAIN_INSTANCES; i++)
 	{
-		return t3_execution;
+		if (chain_instances[i].chain == NULL)
+		{
+			chain_instances[i].chain = &chains[chain_id];
+			chain_instances[i].release_time = release_time;
+			chain_instances[i].released = 0;
+			chain_instances[i].completed = 0;
+			release_chain_stages(i, active_list, stats);
+			return;
+		}
 	}
-	else
-		return 0;
+	DD_LOG("Error: no free chain instance for chain %d\n", chain_id);
 }
 
-void print_event(int event_num, int task_num, message_type type, int measured_time)
+void chain_stage_done(dd_task *task, dd_task_node **active_list, dd_stats *stats)
 {
-	if (measured_time <= HYPER_PERIOD)
+	dd_chain_instance *instance = &chain_instances[task->chain];
+
+	instance->completed |= (1 << task->stage);
+	if (instance->completed == (1 << instance->chain->num_stages) - 1)
 	{
-		printf("\t%d\t\tTask %d ", event_num, task_num);
-		type == release ? printf("released") : printf("completed");
-		printf("\t\t\t%d\n", measured_time);
+		// Whole chain finished, free the slot
+		instance->chain = NULL;
+		return;
 	}
-	else if (!hyper_period_complete)
+	release_chain_stages(task->chain, active_list, stats);
+}
+
+/* Releases every stage whose predecessors have all completed. */
+void release_chain_stages(uint8_t instance, dd_task_node **active_list, dd_stats *stats)
+{
+	dd_chain_instance *chain_instance = &chain_instances[instance];
+	const dd_chain *chain = chain_instance->chain;
+	dd_task new_task;
+	uint8_t stage;
+
+	for (stage = 0; stage < chain->num_stages; stage++)
 	{
-		hyper_period_complete = 1;
+		if ((chain_instance->released & (1 << stage)) ||
+			(chain->stages[stage].predecessors & ~chain_instance->completed))
+		{
+			continue;
+		}
+
+		new_task.t_handle = NULL; // runs on the worker pool
+		new_task.type = APERIODIC;
+		new_task.task_id = ++CHAIN_ID;
+		new_task.task_number = CHAIN_TASK_NUMBER;
+		new_task.release_time = xTaskGetTickCount();
+		new_task.absolute_deadline = chain_instance->release_time + get_stage_deadline(chain, stage);
+		new_task.completion_time = 0;
+		new_task.chain = instance;
+		new_task.stage = stage;
+		new_task.seq = 0;
+		stamp_release(&new_task.times);
+		assign_job_slot(&new_task);
+		dd_trace(TRACE_RELEASE, new_task.task_id, new_task.task_number, new_task.slot);
+
+		chain_instance->released |= (1 << stage);
+		insert_at_back(active_list, new_task);
+		stats->released_count++;
+		stats->active_count++;
 	}
 }
 
-void move_overdue_tasks(dd_task_node **active_list, dd_task_node **overdue_list)
+/*
+Intermediate deadline of a stage, relative to the chain release. The end-to-end deadline is split
+in proportion to the execution time on the longest path ending at the stage, so the last stage on
+the critical path gets the full end-to-end deadline.
+*/
+TickType_t get_stage_deadline(const dd_chain *chain, uint8_t stage)
 {
-	dd_task_node *prev = NULL;
-	dd_task_node *curr = *active_list;
+	int path[MAX_CHAIN_STAGES];
+	int longest = 0;
+	uint8_t i;
+	uint8_t j;
 
-	while (curr != NULL)
+	for (i = 0; i < chain->num_stages; i++)
 	{
-		// Task is overdue
-		if ((xTaskGetTickCount() + get_period_TICKS(curr->task.task_number)) > curr->task.absolute_deadline)
+		path[i] = 0;
+		for (j = 0; j < i; j++)
 		{
-			// Task is overdue, move it to the overdue_list
-			insert_at_back(overdue_list, curr->task);
+			if ((chain->stages[i].predecessors & (1 << j)) && path[j] > path[i])
+			{
+				path[i] = path[j];
+			}
 		}
-		else
+		path[i] += chain->stages[i].execution;
+		if (path[i] > longest)
 		{
-			// Task is not overdue, move to the next task
-			prev = curr;
-			curr = curr->next_task;
+			longest = path[i];
 		}
 	}
+
+	return pdMS_TO_TICKS(chain->deadline) * path[stage] / longest;
 }
 
-/* Timer callback functions. */
-void generator1_callback(TimerHandle_t xTimer)
+/*
+Runs on the worker, not the DDS. A stage that went overdue after it was handed to its worker counts
+as done, so the DDS may already have torn the instance down (chain NULL) or reused it for another
+chain. Such a job has missed its deadline anyway and finishes without doing any work.
+*/
+int get_stage_execution_time(dd_task *task)
+{
+	const dd_chain *chain = chain_instances[task->chain].chain;
+
+	if (chain == NULL || task->stage >= chain->num_stages)
+	{
+		return 0;
+	}
+	return chain->stages[task->stage].execution;
+}
+
+/* Asynchronous API, see the *_async description at the top of this file. */
+dd_ticket release_dd_task_async(TaskHandle_t t_handle, task_type type, uint32_t task_id, uint16_t task_number,
+								dd_callback callback, void *context)
+{
+	return release_dd_task_at_async(t_handle, type, task_id, task_number, xTaskGetTickCount(), callback, context);
+}
+
+dd_ticket release_dd_task_at_async(TaskHandle_t t_handle, task_type type, uint32_t task_id, uint16_t task_number,
+								   TickType_t release_time, dd_callback callback, void *context)
 {
-	vTaskResume(pxTaskGen1);
+	dd_message new_message;
+	new_message.type = release;
+	new_message.task.t_handle = t_handle;
+	new_message.task.type = type;
+	new_message.task.task_id = task_id;
+	new_message.task.task_number = task_number;
+	new_message.task.release_time = release_time;
+	new_message.task.chain = NO_CHAIN;
+	new_message.task.stage = 0;
+	new_message.task.slot = NO_SLOT;
+	new_message.task.seq = 0;
+	stamp_release(&new_message.task.times);
+	new_message.list = NULL;
+
+	return send_async(&new_message, callback, context);
 }
 
-void generator2_callback(TimerHandle_t xTimer)
+dd_ticket complete_dd_task_async(dd_task task, dd_callback callback, void *context)
 {
-	vTaskResume(pxTaskGen2);
+	dd_message new_message;
+	new_message.type = complete;
+	new_message.task = task;
+	new_message.task.times.completion_us = dd_time_us();
+	dd_trace(TRACE_COMPLETE, task.task_id, task.task_number, task.slot);
+
+	return send_async(&new_message, callback, context);
 }
 
-void generator3_callback(TimerHandle_t xTimer)
+dd_ticket release_dd_chain_async(uint8_t chain_id, dd_callback callback, void *context)
 {
-	vTaskResume(pxTaskGen3);
+	dd_message new_message;
+	new_message.type = release_chain;
+	new_message.task.chain = chain_id;
+	new_message.task.release_time = xTaskGetTickCount();
+	new_message.list = NULL;
+
+	return send_async(&new_message, callback, context);
 }
 
-void monitor_callback(TimerHandle_t xTimer)
+dd_ticket release_dd_task_batch_async(const job_desc *jobs, size_t n, dd_callback callback, void *context)
 {
-	vTaskResume(pxMonitor);
+	dd_message new_message;
+
+	if (n > MAX_BATCH_SIZE)
+	{
+		return DD_TICKET_NONE;
+	}
+
+	new_message.type = release_batch;
+	new_message.list = NULL;
+	new_message.jobs = jobs;
+	new_message.num_jobs = n;
+	new_message.sender = NULL;
+
+	return send_async(&new_message, callback, context);
 }
-/*-----------------------------------------------------------------------------------------------------------------------------------------------------------------------------*/
 
-void vApplicationMallocFailedHook(void)
+dd_ticket get_dd_stats_async(dd_stats *stats, dd_callback callback, void *context)
 {
-	/* The malloc failed hook is enabled by setting
-	configUSE_MALLOC_FAILED_HOOK to 1 in FreeRTOSConfig.h.
+	dd_message message;
+	message.type = get_stats;
+	message.list = NULL;
+	message.stats = stats;
+	message.histograms = NULL;
 
-	Called if a call to pvPortMalloc() fails because there is insufficient
-	free memory available in the FreeRTOS heap.  pvPortMalloc() is called
-	internally by FreeRTOS API functions that create tasks, queues, software
-	timers, and semaphores.  The size of the FreeRTOS heap is set by the
-	configTOTAL_HEAP_SIZE configuration constant in FreeRTOSConfig.h. */
-	for (;;)
-		;
+	return send_async(&message, callback, context);
 }
-/*-----------------------------------------------------------*/
 
-void vApplicationStackOverflowHook(xTaskHandle pxTask, signed char *pcTaskName)
+dd_ticket get_dd_histograms_async(uint16_t task_number, dd_histograms *out, dd_callback callback, void *context)
 {
-	(void)pcTaskName;
-	(void)pxTask;
+	dd_message message;
+	message.type = get_histograms;
+	message.list = NULL;
+	message.task.task_number = task_number;
+	message.histograms = out;
 
-	/* Run time stack overflow checking is performed if
-	configconfigCHECK_FOR_STACK_OVERFLOW is defined to 1 or 2.  This hook
-	function is called if a stack overflow is detected.  pxCurrentTCB can be
-	inspected in the debugger if the task name passed into this function is
-	corrupt. */
-	for (;;)
-		;
+	return send_async(&message, callback, context);
 }
-/*-----------------------------------------------------------*/
 
-void vApplicationIdleHook(void)
+dd_ticket get_active_tasks_async(dd_task *out, size_t cap, size_t *n, dd_callback callback, void *context)
 {
-	volatile size_t xFreeStackSpace;
+	dd_message message;
+	message.type = snapshot_active;
+	message.list = NULL;
+	message.snapshot = out;
+	message.capacity = cap;
+	message.from_seq = 0;
+	message.count = n;
 
-	/* The idle task hook is enabled by setting configUSE_IDLE_HOOK to 1 in
-	FreeRTOSConfig.h.
+	return send_async(&message, callback, context);
+}
 
-	This function is called on each cycle of the idle task.  In this case it
-	does nothing useful, other than report the amount of FreeRTOS heap that
-	remains unallocated. */
-	xFreeStackSpace = xPortGetFreeHeapSize();
+dd_ticket get_completed_tasks_async(dd_task *out, size_t cap, uint32_t from_seq, size_t *n,
+									dd_callback callback, void *context)
+{
+	dd_message message;
+	message.type = snapshot_completed;
+	message.list = NULL;
+	message.snapshot = out;
+	message.capacity = cap;
+	message.from_seq = from_seq;
+	message.count = n;
+
+	return send_async(&message, callback, context);
+}
+
+dd_ticket get_overdue_tasks_async(dd_task *out, size_t cap, uint32_t from_seq, size_t *n,
+								  dd_callback callback, void *context)
+{
+	dd_message message;
+	message.type = snapshot_overdue;
+	message.list = NULL;
+	message.snapshot = out;
+	message.capacity = cap;
+	message.from_seq = from_seq;
+	message.count = n;
+
+	return send_async(&message, callback, context);
+}
+
+/*
+Returns the state of a ticket. A ticket without callback is freed when it is polled as done.
+*/
+dd_ticket_state dd_ticket_poll(dd_ticket ticket)
+{
+	dd_ticket_slot *slot;
+	dd_ticket_state state = TICKET_UNKNOWN;
+
+	taskENTER_CRITICAL();
+	slot = find_ticket(ticket);
+	if (slot != NULL)
+	{
+		state = slot->state;
+		if (state == TICKET_DONE && slot->callback == NULL)
+		{
+			free_ticket(slot);
+		}
+	}
+	taskEXIT_CRITICAL();
+	return state;
+}
+
+/*
+For callers that do not care about the outcome: the ticket is freed as soon as it is done.
+*/
+void dd_ticket_release(dd_ticket ticket)
+{
+	dd_ticket_slot *slot;
+
+	taskENTER_CRITICAL();
+	slot = find_ticket(ticket);
+	if (slot != NULL)
+	{
+		if (slot->state == TICKET_DONE && slot->callback == NULL)
+		{
+			free_ticket(slot);
+		}
+		else
+		{
+			slot->released = 1;
+		}
+	}
+	taskEXIT_CRITICAL();
+}
+
+/*
+Takes a free ticket and queues the message without blocking. Returns DD_TICKET_NONE, and counts a
+rejected send, if there is no free ticket or the lane is full.
+*/
+dd_ticket send_async(dd_message *message, dd_callback callback, void *context)
+{
+	dd_ticket_slot *slot = NULL;
+	dd_ticket ticket = DD_TICKET_NONE;
+	int i;
+
+	taskENTER_CRITICAL();
+	for (i = 0; i < MAX_TICKETS; i++)
+	{
+		if (tickets[i].ticket == DD_TICKET_NONE)
+		{
+			slot = &tickets[i];
+			if (++last_ticket == DD_TICKET_NONE)
+			{
+				++last_ticket;
+			}
+			ticket = last_ticket;
+			slot->ticket = ticket;
+			slot->state = TICKET_PENDING;
+			slot->callback = callback;
+			slot->context = context;
+			slot->released = 0;
+			break;
+		}
+	}
+	if (slot == NULL)
+	{
+		rejected_sends[get_lane(message->type)]++;
+	}
+	taskEXIT_CRITICAL();
+
+	if (slot == NULL)
+	{
+		return DD_TICKET_NONE;
+	}
+
+	message->ticket = ticket;
+	if (send_message(message, 0) != pdPASS)
+	{
+		taskENTER_CRITICAL();
+		free_ticket(slot);
+		taskEXIT_CRITICAL();
+		return DD_TICKET_NONE;
+	}
+	return ticket;
+}
+
+/* Must be called inside a critical section. */
+dd_ticket_slot *find_ticket(dd_ticket ticket)
+{
+	int i;
+
+	if (ticket == DD_TICKET_NONE)
+	{
+		return NULL;
+	}
+	for (i = 0; i < MAX_TICKETS; i++)
+	{
+		if (tickets[i].ticket == ticket)
+		{
+			return &tickets[i];
+		}
+	}
+	return NULL;
+}
+
+/* Must be called inside a critical section. */
+void free_ticket(dd_ticket_slot *slot)
+{
+	slot->ticket = DD_TICKET_NONE;
+	slot->state = TICKET_UNKNOWN;
+}
+
+/*
+Called by the DDS once an async request has been processed. Callbacks are handed to the service
+task; the callback queue holds MAX_TICKETS entries, so it can never be full.
+*/
+void complete_ticket(dd_ticket ticket)
+{
+	dd_ticket_slot *slot;
+	BaseType_t run_callback = pdFALSE;
+
+	taskENTER_CRITICAL();
+	slot = find_ticket(ticket);
+	if (slot != NULL)
+	{
+		slot->state = TICKET_DONE;
+		if (slot->callback != NULL)
+		{
+			run_callback = pdTRUE;
+		}
+		else if (slot->released)
+		{
+			free_ticket(slot);
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	if (run_callback)
+	{
+		queue_send(QUEUE_CALLBACKS, xQueueCallbacks, &ticket, 0);
+	}
+}
+
+/*
+Runs completion callbacks for async requests outside the DDS, then frees their tickets.
+*/
+void dd_callback_service(void *pvParameters)
+{
+	dd_ticket ticket;
+	dd_ticket_slot *slot;
+	dd_callback callback;
+	void *context;
+
+	while (1)
+	{
+		if (xQueueReceive(xQueueCallbacks, &ticket, portMAX_DELAY))
+		{
+			callback = NULL;
+			taskENTER_CRITICAL();
+			slot = find_ticket(ticket);
+			if (slot != NULL)
+			{
+				callback = slot->callback;
+				context = slot->context;
+				free_ticket(slot);
+			}
+			taskEXIT_CRITICAL();
+
+			if (callback != NULL)
+			{
+				callback(ticket, context);
+			}
+		}
+	}
+}
+
+/*
+Answers a query, either on the response queue for a blocking caller or by completing its ticket.
+*/
+void reply_to_sender(dd_message *message)
+{
+	if (message->ticket != DD_TICKET_NONE)
+	{
+		complete_ticket(message->ticket);
+	}
+	else
+	{
+		queue_send(QUEUE_RESPONSES, xQueueResponses, message, portMAX_DELAY);
+	}
+}
+
+dd_lane get_lane(message_type type)
+{
+	if (type == release || type == release_batch || type == release_chain || type == complete)
+	{
+		return LANE_EVENTS;
+	}
+	return LANE_QUERIES;
+}
+
+/*
+Queues a message on the lane matching its type, blocking while the lane is full, and rings the DDS
+doorbell.
+*/
+void send_to_dds(dd_message *message)
+{
+	message->ticket = DD_TICKET_NONE;
+	send_message(message, portMAX_DELAY);
+}
+
+/*
+Queues a message on its lane and rings the DDS doorbell. A full lane is counted as a rejected send
+when the caller does not wait, and as a retried send when it does.
+*/
+BaseType_t send_message(dd_message *message, TickType_t wait)
+{
+	dd_lane lane = get_lane(message->type);
+	dd_queue id = (lane == LANE_EVENTS) ? QUEUE_EVENTS : QUEUE_QUERIES;
+	xQueueHandle queue = (lane == LANE_EVENTS) ? xQueueEvents : xQueueQueries;
+
+	message->sent_time = xTaskGetTickCount();
+	message->sent_us = dd_time_us();
+
+	if (xQueueSendToBack(queue, message, 0) != pdTRUE)
+	{
+		taskENTER_CRITICAL();
+		if (wait == 0)
+		{
+			rejected_sends[lane]++;
+		}
+		else
+		{
+			retried_sends[lane]++;
+		}
+		taskEXIT_CRITICAL();
+
+		if (wait == 0 || queue_send(id, queue, message, wait) != pdTRUE)
+		{
+			return pdFAIL;
+		}
+	}
+	else
+	{
+		queue_peak(id, queue);
+	}
+
+	xTaskNotify(pxDDS, (lane == LANE_EVENTS) ? DDS_NOTIFY_EVENTS : DDS_NOTIFY_QUERIES, eSetBits);
+	return pdPASS;
+}
+
+/*
+Sends on one of the DDS queues and records its peak occupancy. A send that finds the queue full and
+waits is counted along with the time it spent blocked.
+*/
+BaseType_t queue_send(dd_queue id, xQueueHandle queue, const void *item, TickType_t wait)
+{
+	BaseType_t sent;
+	uint32_t start;
+
+	sent = xQueueSendToBack(queue, item, 0);
+	if (sent != pdTRUE && wait != 0)
+	{
+		start = dd_time_us();
+		sent = xQueueSendToBack(queue, item, wait);
+		taskENTER_CRITICAL();
+		queue_stats[id].blocked_sends++;
+		queue_stats[id].send_blocked_us += dd_time_us() - start;
+		taskEXIT_CRITICAL();
+	}
+	if (sent == pdTRUE)
+	{
+		queue_peak(id, queue);
+	}
+	return sent;
+}
+
+/*
+Receives from one of the DDS queues. A receive that finds the queue empty and waits is counted
+along with the time it spent blocked, which for the response queue is the wait for the DDS to answer.
+*/
+BaseType_t queue_receive(dd_queue id, xQueueHandle queue, void *item, TickType_t wait)
+{
+	BaseType_t received;
+	uint32_t start;
+
+	received = xQueueReceive(queue, item, 0);
+	if (received != pdTRUE && wait != 0)
+	{
+		start = dd_time_us();
+		received = xQueueReceive(queue, item, wait);
+		taskENTER_CRITICAL();
+		queue_stats[id].blocked_receives++;
+		queue_stats[id].receive_blocked_us += dd_time_us() - start;
+		taskEXIT_CRITICAL();
+	}
+	return received;
+}
+
+/*
+Raises the peak occupancy of a queue to the number of messages now waiting on it. A receiver of
+higher priority may already have taken the message, so a peak can read one low.
+*/
+void queue_peak(dd_queue id, xQueueHandle queue)
+{
+	UBaseType_t waiting;
+
+	taskENTER_CRITICAL();
+	waiting = uxQueueMessagesWaiting(queue);
+	if (waiting > queue_stats[id].peak)
+	{
+		queue_stats[id].peak = waiting;
+	}
+	taskEXIT_CRITICAL();
+}
+
+/*
+Takes the next message for the DDS without blocking. The event lane is always checked first, so a
+query is only served once no release/complete is pending. Records per-lane queueing latency.
+*/
+BaseType_t receive_message(dd_message *message, dd_stats *stats)
+{
+	dd_lane lane;
+	uint32_t latency;
+
+	if (xQueueReceive(xQueueEvents, message, 0) == pdTRUE)
+	{
+		lane = LANE_EVENTS;
+	}
+	else if (xQueueReceive(xQueueQueries, message, 0) == pdTRUE)
+	{
+		lane = LANE_QUERIES;
+	}
+	else
+	{
+		return pdFALSE;
+	}
+
+	latency = dd_time_us() - message->sent_us;
+	stats->messages[message->type]++;
+	stats->lane_messages[lane]++;
+	stats->lane_latency_total_us[lane] += latency;
+	if (latency > stats->lane_latency_max_us[lane])
+	{
+		stats->lane_latency_max_us[lane] = latency;
+	}
+	return pdTRUE;
+}
+
+/*
+Like receive_message, but completions signalled through job slots come first. Picks up slot bits
+set since the DDS woke up without clearing the lane doorbell bits.
+*/
+BaseType_t next_message(dd_message *message, uint32_t *completions, dd_stats *stats)
+{
+	uint32_t notified;
+	uint8_t slot;
+
+	if (xTaskNotifyWait(0, JOB_SLOT_MASK, &notified, 0) == pdTRUE)
+	{
+		*completions |= notified & JOB_SLOT_MASK;
+	}
+
+	if (*completions == 0)
+	{
+		return receive_message(message, stats);
+	}
+
+	for (slot = 0; !(*completions & (1UL << slot)); slot++)
+		;
+	*completions &= ~(1UL << slot);
+
+	message->type = complete;
+	message->task = job_slots[slot];
+	message->list = NULL;
+	message->ticket = DD_TICKET_NONE;
+	stats->notify_completions++;
+	return pdTRUE;
+}
+
+/*
+Gives a job that brings its own F-Task a free completion slot if there is one, otherwise it
+completes through the queue. Pool jobs get their worker's slot in assign_workers instead.
+*/
+void assign_job_slot(dd_task *task)
+{
+	uint32_t free_slots = free_job_slots & ~WORKER_MASK;
+	uint8_t slot;
+
+	task->slot = NO_SLOT;
+	if (task->t_handle == NULL || free_slots == 0)
+	{
+		return;
+	}
+
+	for (slot = NUM_WORKERS; !(free_slots & (1UL << slot)); slot++)
+		;
+	free_job_slots &= ~(1UL << slot);
+	task->slot = slot;
+	job_slots[slot] = *task;
+}
+
+/* Returns a slot (or worker) to the pool, unless it has already been handed to another job. */
+void free_job_slot(dd_task *task)
+{
+	if (task->slot < MAX_JOB_SLOTS && job_slots[task->slot].task_id == task->task_id)
+	{
+		free_job_slots |= (1UL << task->slot);
+	}
+}
+
+/*
+Hands idle workers to the earliest-deadline jobs that do not have one yet. The job is copied to the
+worker's slot, which doubles as its mailbox, before the worker is notified.
+
+With SRP_POOL a job may only start above the running ones: the walk stops at the first running
+pool job, and after one start, since every later job has a later deadline than it. Running jobs
+stay in the active list until they complete (see move_overdue_tasks), so none is missed.
+*/
+void assign_workers(dd_task_node *active_list)
+{
+	dd_task_node *current = active_list;
+	uint8_t worker;
+
+	while (current != NULL && (free_job_slots & WORKER_MASK) != 0)
+	{
+		// Co-routine DD-Tasks never get a worker
+		if (current->task.t_handle == NULL && current->task.slot != CO_SLOT)
+		{
+			for (worker = 0; !(free_job_slots & (1UL << worker)); worker++)
+				;
+			free_job_slots &= ~(1UL << worker);
+
+			current->task.t_handle = pxWorkers[worker];
+			current->task.slot = worker;
+			job_slots[worker] = current->task;
+			vTaskPrioritySet(pxWorkers[worker], PRIORITY_LOW);
+			xTaskNotifyGive(pxWorkers[worker]);
+#if SRP_POOL
+			break;
+#endif
+		}
+#if SRP_POOL
+		else if (current->task.slot < NUM_WORKERS)
+		{
+			break;
+		}
+#endif
+		current = current->next_task;
+	}
+}
+
+/* Task parameter lookups, task_number 0 (chains) and unknown numbers get defaults. */
+TickType_t get_period_TICKS(uint16_t task_number)
+{
+	if (task_number >= 1 && task_number <= NUM_TASKS)
+	{
+		return pdMS_TO_TICKS(task_table[task_number - 1].period);
+	}
+	return pdMS_TO_TICKS(100);
+}
+
+TickType_t get_deadline_TICKS(uint16_t task_number)
+{
+	if (task_number >= 1 && task_number <= NUM_TASKS)
+	{
+		return pdMS_TO_TICKS(task_table[task_number - 1].deadline);
+	}
+	return pdMS_TO_TICKS(100);
+}
+
+int get_execution_time(uint16_t task_number)
+{
+	if (task_number >= 1 && task_number <= NUM_TASKS)
+	{
+		return task_table[task_number - 1].execution;
+	}
+	return 0;
+}
+
+void (*get_task_body(uint16_t task_number))(dd_task *job)
+{
+	if (task_number >= 1 && task_number <= NUM_TASKS)
+	{
+		return task_table[task_number - 1].body;
+	}
+	return user_defined;
+}
+
+workload_kind get_task_workload(uint16_t task_number)
+{
+	if (task_number >= 1 && task_number <= NUM_TASKS)
+	{
+		return task_table[task_number - 1].workload;
+	}
+	return WORKLOAD_ALU;
+}
+
+/* Share of the CPU a task demands (C/T), in per-mille. */
+uint32_t get_utilisation(uint16_t task_number)
+{
+	TickType_t period = get_period_TICKS(task_number);
+
+	return (uint32_t)pdMS_TO_TICKS(get_execution_time(task_number)) * 1000 / period;
+}
+
+void print_event(int event_num, int task_num, message_type type, int measured_time)
+{
+	if (measured_time <= HYPER_PERIOD)
+	{
+		// Formatted later by the log task, the DDS only queues the numbers
+		if (type == release)
+		{
+			DD_LOG("\t%d\t\tTask %d released\t\t\t%d\n", event_num, task_num, measured_time);
+		}
+		else
+		{
+			DD_LOG("\t%d\t\tTask %d completed\t\t\t%d\n", event_num, task_num, measured_time);
+		}
+	}
+	else if (!hyper_period_complete)
+	{
+		hyper_period_complete = 1;
+	}
+}
+
+void move_overdue_tasks(dd_task_node **active_list, dd_task_node **overdue_list, dd_stats *stats)
+{
+	dd_task_node *prev = NULL;
+	dd_task_node *curr = *active_list;
+	dd_task_node *next;
+	TickType_t currTick = xTaskGetTickCount();
+	int overdue;
+
+	while (curr != NULL)
+	{
+		next = curr->next_task;
+
+		overdue = currTick > curr->task.absolute_deadline;
+#if SRP_POOL
+		// A running pool job holds its nesting level until it completes, the completion moves it to
+		// the overdue list
+		overdue = overdue && curr->task.slot >= NUM_WORKERS;
+#endif
+		// Task is overdue
+		if (overdue)
+		{
+			// Task is overdue, unlink it and move it to the overdue_list
+			if (prev == NULL)
+			{
+				*active_list = next;
+			}
+			else
+			{
+				prev->next_task = next;
+			}
+
+			if (curr->task.slot != NO_SLOT && curr->task.slot < NUM_WORKERS)
+			{
+				// Worker finishes the job in the background and is freed when it completes
+				vTaskPrioritySet(curr->task.t_handle, PRIORITY_LOW);
+			}
+			else if (curr->task.t_handle != NULL)
+			{
+				// F-Task is no longer scheduled. Its releaser owns it and may have handed it to other
+				// jobs, so park it rather than delete it; parked, it cannot signal the freed slot
+				vTaskSuspend(curr->task.t_handle);
+				free_job_slot(&curr->task);
+			}
+			curr->task.completion_time = currTick;
+			curr->task.seq = ++history_seq;
+			stats->active_count--;
+			stats->utilisation -= get_utilisation(curr->task.task_number);
+			record_overdue(&curr->task, stats);
+
+			insert_at_back(overdue_list, curr->task);
+			// A missed stage still counts as done so the rest of its chain can run
+			if (curr->task.chain != NO_CHAIN)
+			{
+				chain_stage_done(&curr->task, active_list, stats);
+			}
+			free(curr);
+		}
+		else
+		{
+			// Task is not overdue, move to the next task
+			prev = curr;
+		}
+		curr = next;
+	}
+}
+
+void record_overdue(dd_task *task, dd_stats *stats)
+{
+	TickType_t lateness = task->completion_time - task->absolute_deadline;
+
+	dd_trace(TRACE_MISS, task->task_id, task->task_number, task->slot);
+	stats->overdue_count++;
+	if (task->task_number <= NUM_TASKS)
+	{
+		stats->misses[task->task_number]++;
+	}
+	if (lateness > stats->max_lateness)
+	{
+		stats->max_lateness = lateness;
+	}
+}
+
+/* dd_time_us at the start of the given tick, wraps along with dd_time_us. */
+uint32_t tick_to_us(TickType_t tick)
+{
+	return tick_epoch_us + (uint32_t)tick * portTICK_PERIOD_MS * 1000;
+}
+
+/* Histogram bucket of a value, see HIST_BUCKETS. */
+uint32_t hist_bucket(uint32_t value)
+{
+	uint32_t msb;
+	uint32_t bucket;
+
+	if (value < 2)
+	{
+		return value;
+	}
+	msb = 31 - __builtin_clz(value);
+	bucket = 2 * msb + ((value >> (msb - 1)) & 1);
+	return (bucket < HIST_BUCKETS) ? bucket : HIST_BUCKETS - 1;
+}
+
+/* Largest value that falls into a bucket. */
+uint32_t hist_bucket_limit(uint32_t bucket)
+{
+	if (bucket + 1 >= HIST_BUCKETS)
+	{
+		return UINT32_MAX;
+	}
+	if (bucket < 2)
+	{
+		return bucket;
+	}
+	// Lower bound of the next bucket, minus one
+	return ((2 | ((bucket + 1) & 1)) << ((bucket + 1) / 2 - 1)) - 1;
+}
+
+void hist_add(dd_histogram *histogram, uint32_t value)
+{
+	histogram->buckets[hist_bucket(value)]++;
+	histogram->count++;
+	if (value > histogram->max)
+	{
+		histogram->max = value;
+	}
+}
+
+/* Upper bound of the given percentile (in per-mille, 990 = p99), never more than the maximum seen. */
+uint32_t hist_percentile(const dd_histogram *histogram, uint32_t per_mille)
+{
+	uint32_t target = (uint32_t)(((uint64_t)histogram->count * per_mille + 999) / 1000);
+	uint32_t seen = 0;
+	uint32_t bucket;
+
+	for (bucket = 0; bucket < HIST_BUCKETS; bucket++)
+	{
+		seen += histogram->buckets[bucket];
+		if (seen >= target && seen > 0)
+		{
+			break;
+		}
+	}
+	if (bucket >= HIST_BUCKETS || hist_bucket_limit(bucket) > histogram->max)
+	{
+		return histogram->max;
+	}
+	return hist_bucket_limit(bucket);
+}
+
+/* Release jitter of a periodic task: how far the interval since its previous release is from T. */
+void record_release(dd_task *task)
+{
+	uint32_t index = task->task_number - 1;
+	uint32_t interval;
+	uint32_t period_us;
+
+	if (task->task_number < 1 || task->task_number > NUM_TASKS || task->type != PERIODIC)
+	{
+		return;
+	}
+	if (last_release_us[index] != 0)
+	{
+		interval = task->times.release_us - last_release_us[index];
+		period_us = (uint32_t)task_table[index].period * 1000;
+		hist_add(&task_histograms[index].metric[METRIC_JITTER],
+				 (interval > period_us) ? interval - period_us : period_us - interval);
+	}
+	last_release_us[index] = task->times.release_us;
+}
+
+/* Response time, and lateness or slack against the absolute deadline the DDS counts misses against. */
+void record_completion(dd_task *task)
+{
+	dd_histograms *histograms;
+	uint32_t response;
+	int32_t lateness;
+
+	// Completions built by the caller rather than from a released job (the bench) carry no release stamp
+	if (task->task_number < 1 || task->task_number > NUM_TASKS || task->times.release_us == 0 ||
+		task->times.completion_us == 0)
+	{
+		return;
+	}
+	histograms = &task_histograms[task->task_number - 1];
+	response = task->times.completion_us - task->times.release_us;
+	lateness = (int32_t)(task->times.completion_us - tick_to_us(task->absolute_deadline));
+
+	hist_add(&histograms->metric[METRIC_RESPONSE], response);
+	if (lateness > 0)
+	{
+		hist_add(&histograms->metric[METRIC_LATENESS], (uint32_t)lateness);
+	}
+	else
+	{
+		hist_add(&histograms->metric[METRIC_SLACK], (uint32_t)-lateness);
+	}
+}
+
+/*
+Monitor output, a single log entry per task so the report stays within the log ring for larger task
+sets. The full histograms remain available through get_dd_histograms.
+*/
+void print_task_summary(uint16_t task_number, const dd_stats *stats, const dd_histograms *histograms)
+{
+	DD_LOG("Task %d: %d misses, %d lost releases, max release jitter (us): %d, p99 response (us): %d, "
+		   "max lateness (us): %d\n",
+		   task_number, (int)stats->misses[task_number], (int)stats->lost_releases[task_number],
+		   (int)release_jitter_max[task_number], (int)hist_percentile(&histograms->metric[METRIC_RESPONSE], 990),
+		   (int)histograms->metric[METRIC_LATENESS].max);
+}
+
+/*
+CPU share of each task since start-up from the FreeRTOS run-time counters, in per-mille. The DDS's
+own share is the scheduler's overhead, also given per released job. Workers are listed one by one,
+tasks the monitor does not know (generators, F-Tasks) are summed as other.
+*/
+void print_cpu_usage(uint32_t released_count)
+{
+	UBaseType_t count;
+	uint32_t total;
+	uint32_t dds = 0;
+	uint32_t idle = 0;
+	uint32_t workers = 0;
+	uint32_t services = 0;
+	uint32_t other = 0;
+	uint32_t worker_time[NUM_WORKERS] = {0};
+	TaskHandle_t idle_handle = xTaskGetIdleTaskHandle();
+	TaskHandle_t timer_handle = xTimerGetTimerDaemonTaskHandle();
+	TaskHandle_t handle;
+	UBaseType_t i;
+	uint32_t worker;
+
+	count = uxTaskGetSystemState(task_status, MAX_TASK_STATUS, &total);
+	if (count == 0 || total == 0)
+	{
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		handle = task_status[i].xHandle;
+		if (handle == pxDDS)
+		{
+			dds = task_status[i].ulRunTimeCounter;
+			continue;
+		}
+		if (handle == idle_handle)
+		{
+			idle = task_status[i].ulRunTimeCounter;
+			continue;
+		}
+		if (handle == pxMonitor || handle == pxCallbackService || handle == pxLog || handle == timer_handle)
+		{
+			services += task_status[i].ulRunTimeCounter;
+			continue;
+		}
+		for (worker = 0; worker < NUM_WORKERS && handle != pxWorkers[worker]; worker++)
+			;
+		if (worker < NUM_WORKERS)
+		{
+			worker_time[worker] = task_status[i].ulRunTimeCounter;
+			workers += task_status[i].ulRunTimeCounter;
+		}
+		else
+		{
+			other += task_status[i].ulRunTimeCounter;
+		}
+	}
+
+	DD_LOG("CPU (per-mille): DDS %d, idle %d, workers %d\n", (int)((uint64_t)dds * 1000 / total),
+		   (int)((uint64_t)idle * 1000 / total), (int)((uint64_t)workers * 1000 / total));
+	DD_LOG("CPU (per-mille): monitor/callbacks/log/timer %d, other tasks %d\n",
+		   (int)((uint64_t)services * 1000 / total), (int)((uint64_t)other * 1000 / total));
+	for (worker = 0; worker < NUM_WORKERS; worker++)
+	{
+		DD_LOG("Worker %d CPU (per-mille): %d\n", (int)worker, (int)((uint64_t)worker_time[worker] * 1000 / total));
+	}
+	if (released_count > 0)
+	{
+		DD_LOG("DDS CPU per released job (us): %d\n", (int)((uint64_t)dds * 1000000 / DD_RUNTIME_HZ / released_count));
+	}
+}
+
+/* Queue occupancy and backpressure, and the message mix the DDS has handled. Queues are numbered
+as in dd_queue, from 1. */
+void print_queue_stats(const dd_stats *stats)
+{
+	const dd_queue_stats *queue;
+	int i;
+
+	for (i = 0; i < NUM_QUEUES; i++)
+	{
+		queue = &stats->queues[i];
+		DD_LOG("Queue %d: peak %d of %d, %d blocked sends\n", i + 1, (int)queue->peak, (int)queue->capacity,
+			   (int)queue->blocked_sends);
+		DD_LOG("Queue %d: %d blocked receives, blocked (us) in sends %d, in receives %d\n", i + 1,
+			   (int)queue->blocked_receives, (int)queue->send_blocked_us, (int)queue->receive_blocked_us);
+		if (queue->peak * 100 >= queue->capacity * QUEUE_WARN_PERCENT)
+		{
+			DD_LOG("Queue %d is close to full, raise its size\n", i + 1);
+		}
+	}
+	DD_LOG("Messages: release %d, release_chain %d, release_batch %d, complete %d\n",
+		   (int)stats->messages[release], (int)stats->messages[release_chain],
+		   (int)stats->messages[release_batch], (int)stats->messages[complete]);
+	DD_LOG("Messages: get_active %d, get_completed %d, get_overdue %d, get_stats %d\n",
+		   (int)stats->messages[get_active], (int)stats->messages[get_completed],
+		   (int)stats->messages[get_overdue], (int)stats->messages[get_stats]);
+	DD_LOG("Messages: snapshot_active %d, snapshot_completed %d, snapshot_overdue %d, get_histograms %d\n",
+		   (int)stats->messages[snapshot_active], (int)stats->messages[snapshot_completed],
+		   (int)stats->messages[snapshot_overdue], (int)stats->messages[get_histograms]);
+}
+
+/* Least free stack (words) each task has had so far, against which STACK_MARGIN is checked. */
+void print_stack_headroom(void)
+{
+	UBaseType_t dds = uxTaskGetStackHighWaterMark(pxDDS);
+	UBaseType_t monitor = uxTaskGetStackHighWaterMark(NULL);
+	UBaseType_t service = uxTaskGetStackHighWaterMark(pxCallbackService);
+	UBaseType_t log = uxTaskGetStackHighWaterMark(pxLog);
+	UBaseType_t timer = uxTaskGetStackHighWaterMark(xTimerGetTimerDaemonTaskHandle());
+	UBaseType_t idle = uxTaskGetStackHighWaterMark(xTaskGetIdleTaskHandle());
+	UBaseType_t worker = WORKER_STACK_SIZE;
+	UBaseType_t free;
+	uint32_t i;
+
+	for (i = 0; i < NUM_WORKERS; i++)
+	{
+		free = uxTaskGetStackHighWaterMark(pxWorkers[i]);
+		if (free < worker)
+		{
+			worker = free;
+		}
+	}
+
+	DD_LOG("Stack free (words): DDS %d, monitor %d, callbacks %d, log %d\n", (int)dds, (int)monitor,
+		   (int)service, (int)log);
+	DD_LOG("Stack free (words): worker %d, timer %d, idle %d\n", (int)worker, (int)timer, (int)idle);
+	if (dds < STACK_MARGIN || monitor < STACK_MARGIN || service < STACK_MARGIN || log < STACK_MARGIN ||
+		worker < STACK_MARGIN || timer < STACK_MARGIN || idle < STACK_MARGIN)
+	{
+		DD_LOG("Stack headroom below STACK_MARGIN, raise the stack depths\n");
+	}
+}
+
+/* Names for the TCB and queue numbers in kernel trace events, read by tools/dd_trace_export.py. */
+void print_trace_names(void)
+{
+	UBaseType_t count;
+	UBaseType_t i;
+
+	count = uxTaskGetSystemState(task_status, MAX_TASK_STATUS, NULL);
+	for (i = 0; i < count; i++)
+	{
+		printf("TRACE-TASK %u %s\n", (unsigned)task_status[i].xTaskNumber, task_status[i].pcTaskName);
+	}
+	printf("TRACE-QUEUE 1 events\nTRACE-QUEUE 2 queries\nTRACE-QUEUE 3 responses\nTRACE-QUEUE 4 callbacks\n");
+}
+
+/* Timer callback functions. */
+void generator_callback(TimerHandle_t xTimer)
+{
+	uint32_t index = (uint32_t)pvTimerGetTimerID(xTimer);
+
+	release_next(index);
+
+	// Re-arm against the next nominal release, not against now, so lateness does not accumulate.
+	// If we are a whole period behind the missed release follows on the next tick.
+	if (task_table[index].type == PERIODIC)
+	{
+		xTimerChangePeriod(xTimer, dd_release_delay(next_release[index], xTaskGetTickCount()), 0);
+	}
+}
+
+void monitor_callback(TimerHandle_t xTimer)
+{
+	vTaskResume(pxMonitor);
+}
+
+/* Runs in the timer service task, so the chain goes out without blocking, like generate_release. */
+void chain_callback(TimerHandle_t xTimer)
+{
+	dd_ticket ticket;
+
+	ticket = release_dd_chain_async(0, NULL, NULL);
+	if (ticket == DD_TICKET_NONE)
+	{
+		DD_LOG("Error: chain %d release lost\n", 0);
+		return;
+	}
+	dd_ticket_release(ticket);
+}
+
+#if DDS_BENCH
+volatile dd_task bench_mailbox;
+
+/*
+Release-burst benchmark. For each burst size, releases the burst BENCH_REPETITIONS times as
+individual release_dd_task calls and as one release_dd_task_batch call, and reports the average
+number of cycles until the DDS has taken its dispatch decision for the whole burst. Jobs are
+completed again between bursts so the active list size stays constant.
+
+Completion benchmark. Releases two jobs and completes the earliest one through the queue and
+through its job slot, reporting the average cycles until the DDS has dispatched the next job.
+
+Release cost benchmark. Compares creating and deleting an F-Task per release with handing a job to
+an already created, blocked worker, and reports the FreeRTOS heap consumed per created F-Task.
+
+Co-routine benchmark (configUSE_CO_ROUTINES). Releases CO_BENCH_JOBS zero-length DD-Tasks at once
+to the worker pool and to the co-routine pool, and reports the cycles until all of them have left
+the active list, together with the RAM each flavour needs per concurrent job.
+*/
+void dds_bench(void *pvParameters)
+{
+	TaskHandle_t dummies[MAX_BATCH_SIZE];
+	job_desc jobs[MAX_BATCH_SIZE];
+	dd_task done = {0}; // only the ID fields are filled in, the rest must not be garbage
+	TaskHandle_t handle;
+	TaskHandle_t worker;
+	size_t free_heap;
+	size_t heap_per_task = 0;
+	size_t count;
+	uint32_t id = 5000;
+	uint32_t start;
+	uint32_t cycles[2];
+	int size;
+	int mode;
+	int rep;
+	int i;
+#if configUSE_CO_ROUTINES
+	dd_stats stats;
+#endif
+
+	done.chain = NO_CHAIN;
+	done.slot = NO_SLOT;
+
+	// Jobs need real handles for set_priority/vTaskResume, share a few parked tasks
+	for (i = 0; i < MAX_BATCH_SIZE; i++)
+	{
+		xTaskCreate(bench_dummy, "dummy", configMINIMAL_STACK_SIZE, NULL, PRIORITY_LOW, &dummies[i]);
+	}
+
+	// Wait for print_event to go quiet
+	vTaskDelay(HYPER_PERIOD + 1);
+
+	printf("Burst size\tIndividual (cycles)\tBatch (cycles)\n");
+	for (size = 1; size <= MAX_BATCH_SIZE; size *= 2)
+	{
+		for (mode = 0; mode < 2; mode++)
+		{
+			cycles[mode] = 0;
+			for (rep = 0; rep < BENCH_REPETITIONS; rep++)
+			{
+				for (i = 0; i < size; i++)
+				{
+					jobs[i].t_handle = dummies[i];
+					jobs[i].type = PERIODIC;
+					jobs[i].task_id = ++id;
+					jobs[i].task_number = (i % NUM_TASKS) + 1;
+				}
+
+				// The DDS has a higher priority, so each call returns after it has been processed
+				start = dd_cycles();
+				if (mode == 0)
+				{
+					for (i = 0; i < size; i++)
+					{
+						release_dd_task(jobs[i].t_handle, jobs[i].type, jobs[i].task_id, jobs[i].task_number);
+					}
+				}
+				else
+				{
+					release_dd_task_batch(jobs, size);
+				}
+				cycles[mode] += dd_cycles() - start;
+
+				for (i = 0; i < size; i++)
+				{
+					done.task_id = jobs[i].task_id;
+					done.task_number = jobs[i].task_number;
+					done.slot = NO_SLOT;
+					complete_dd_task(done);
+				}
+			}
+		}
+		printf("%d\t\t%d\t\t\t%d\n", size, (int)(cycles[0] / BENCH_REPETITIONS), (int)(cycles[1] / BENCH_REPETITIONS));
+	}
+
+	printf("Completion\tQueue (cycles)\t\tNotify (cycles)\n");
+	for (mode = 0; mode < 2; mode++)
+	{
+		cycles[mode] = 0;
+		for (rep = 0; rep < BENCH_REPETITIONS; rep++)
+		{
+			release_dd_task(dummies[0], PERIODIC, ++id, 1);
+			release_dd_task(dummies[1], PERIODIC, ++id, 3);
+
+			// Head of the active list is the task 1 job, with the slot the DDS gave it
+			get_active_tasks(&done, 1, &count);
+			if (mode == 0)
+			{
+				done.slot = NO_SLOT;
+			}
+
+			start = dd_cycles();
+			complete_dd_task(done);
+			cycles[mode] += dd_cycles() - start;
+
+			get_active_tasks(&done, 1, &count);
+			complete_dd_task(done);
+		}
+	}
+	printf("\t\t%d\t\t\t%d\n", (int)(cycles[0] / BENCH_REPETITIONS), (int)(cycles[1] / BENCH_REPETITIONS));
+
+	xTaskCreate(bench_worker, "bworker", WORKER_STACK_SIZE, NULL, PRIORITY_LOW, &worker);
+	printf("Release cost\tCreate+delete (cycles)\tPool hand-off (cycles)\n");
+	cycles[0] = 0;
+	cycles[1] = 0;
+	for (rep = 0; rep < BENCH_REPETITIONS; rep++)
+	{
+		free_heap = xPortGetFreeHeapSize();
+		start = dd_cycles();
+		xTaskCreate(bench_dummy, "ftask", configMINIMAL_STACK_SIZE, NULL, PRIORITY_LOW, &handle);
+		heap_per_task = free_heap - xPortGetFreeHeapSize();
+		vTaskDelete(handle);
+		cycles[0] += dd_cycles() - start;
+
+		start = dd_cycles();
+		bench_mailbox = done;
+		xTaskNotifyGive(worker);
+		cycles[1] += dd_cycles() - start;
+	}
+	printf("\t\t%d\t\t\t%d\n", (int)(cycles[0] / BENCH_REPETITIONS), (int)(cycles[1] / BENCH_REPETITIONS));
+	printf("Heap per created F-Task (bytes): %d, pool of %d workers reserved at init: %d\n",
+		   (int)heap_per_task, NUM_WORKERS, (int)(heap_per_task * NUM_WORKERS));
+
+	// Overhead across active-set sizes, the list operations alone and then whole DDS round trips
+	dd_bench_header();
+	dd_bench_release_drift();
+	dd_bench_lists();
+	bench_dds_round_trips(dummies, &id);
+
+#if configUSE_CO_ROUTINES
+	// Task number past the table: no execution time, default deadline
+	printf("%d concurrent jobs\tworkers\t\tco-routines\n", CO_BENCH_JOBS);
+	for (mode = 0; mode < 2; mode++)
+	{
+		get_dd_stats(&stats);
+		count = stats.completed_count + stats.overdue_count;
+		start = dd_cycles();
+		for (i = 0; i < CO_BENCH_JOBS; i++)
+		{
+			if (mode == 0)
+			{
+				release_dd_task(NULL, PERIODIC, ++id, NUM_TASKS + 1);
+			}
+			else
+			{
+				release_dd_co_task(PERIODIC, ++id, NUM_TASKS + 1);
+			}
+		}
+		do
+		{
+			vTaskDelay(1);
+			get_dd_stats(&stats);
+		} while (stats.completed_count + stats.overdue_count < count + CO_BENCH_JOBS);
+		cycles[mode] = dd_cycles() - start;
+	}
+	printf("cycles\t\t\t%d\t\t%d\n", (int)cycles[0], (int)cycles[1]);
+	printf("RAM per job (bytes)\t%d (F-Task, %d at a time)\t%d (pool entry)\n",
+		   (int)heap_per_task, NUM_WORKERS, (int)sizeof(dd_co_job));
+#endif
+	vTaskSuspend(NULL);
+}
+
+/*
+Cost of one release, completion and stats query through the DDS with active - 1 parked jobs already
+in the active list, so each sample is a full DDS iteration: message hand-off, move_overdue_tasks,
+sort_EDF, dispatch and set_priority. The jobs use the last task's deadline, the sweep has to finish
+well within it or jobs start moving to the overdue list.
+*/
+uint32_t bench_dds_samples[3][DD_BENCH_SAMPLES];
+
+void bench_dds_round_trips(TaskHandle_t *dummies, uint32_t *id)
+{
+	dd_stats stats;
+	dd_task done = {0};
+	uint32_t first;
+	uint32_t start;
+	int active;
+	int sample;
+	int i;
+
+	done.task_number = NUM_TASKS;
+	done.chain = NO_CHAIN;
+	done.slot = NO_SLOT;
+	for (active = 1; active <= DD_BENCH_MAX_ACTIVE; active *= 2)
+	{
+		first = *id + 1;
+		for (i = 1; i < active; i++)
+		{
+			release_dd_task(dummies[i % MAX_BATCH_SIZE], PERIODIC, ++*id, NUM_TASKS);
+		}
+
+		// The DDS has a higher priority, so each call returns after it has been processed
+		for (sample = 0; sample < DD_BENCH_SAMPLES; sample++)
+		{
+			start = dd_cycles();
+			release_dd_task(dummies[0], PERIODIC, ++*id, NUM_TASKS);
+			bench_dds_samples[0][sample] = dd_cycles() - start;
+
+			done.task_id = *id;
+			start = dd_cycles();
+			complete_dd_task(done);
+			bench_dds_samples[1][sample] = dd_cycles() - start;
+
+			start = dd_cycles();
+			get_dd_stats(&stats);
+			bench_dds_samples[2][sample] = dd_cycles() - start;
+		}
+		dd_bench_report("dds_release", active, bench_dds_samples[0], DD_BENCH_SAMPLES);
+		dd_bench_report("dds_complete", active, bench_dds_samples[1], DD_BENCH_SAMPLES);
+		dd_bench_report("dds_query", active, bench_dds_samples[2], DD_BENCH_SAMPLES);
+
+		for (i = 1; i < active; i++)
+		{
+			done.task_id = first + i - 1;
+			complete_dd_task(done);
+		}
+	}
+}
+
+void bench_worker(void *pvParameters)
+{
+	while (1)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	}
+}
+
+void bench_dummy(void *pvParameters)
+{
+	while (1)
+	{
+		vTaskSuspend(NULL);
+	}
+}
+#endif
+/*-----------------------------------------------------------------------------------------------------------------------------------------------------------------------------*/
+
+void vApplicationMallocFailedHook(void)
+{
+	/* The malloc failed hook is enabled by setting
+	configUSE_MALLOC_FAILED_HOOK to 1 in FreeRTOSConfig.h.
+
+	Called if a call to pvPortMalloc() fails because there is insufficient
+	free memory available in the FreeRTOS heap.  pvPortMalloc() is called
+	internally by FreeRTOS API functions that create tasks, queues, software
+	timers, and semaphores.  The size of the FreeRTOS heap is set by the
+	configTOTAL_HEAP_SIZE configuration constant in FreeRTOSConfig.h. */
+	for (;;)
+		;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationStackOverflowHook(xTaskHandle pxTask, signed char *pcTaskName)
+{
+	(void)pcTaskName;
+	(void)pxTask;
+
+	/* Run time stack overflow checking is performed if
+	configconfigCHECK_FOR_STACK_OVERFLOW is defined to 1 or 2.  This hook
+	function is called if a stack overflow is detected.  pxCurrentTCB can be
+	inspected in the debugger if the task name passed into this function is
+	corrupt. */
+	for (;;)
+		;
+}
+/*-----------------------------------------------------------*/
+
+#if configSUPPORT_STATIC_ALLOCATION
+/* Memory for the kernel's own tasks in the static build. */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+								   uint32_t *pulIdleTaskStackSize)
+{
+	*ppxIdleTaskTCBBuffer = &idle_tcb;
+	*ppxIdleTaskStackBuffer = idle_stack;
+	*pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+									uint32_t *pulTimerTaskStackSize)
+{
+	*ppxTimerTaskTCBBuffer = &timer_service_tcb;
+	*ppxTimerTaskStackBuffer = timer_service_stack;
+	*pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+/*-----------------------------------------------------------*/
+#endif
+
+void vApplicationTickHook(void)
+{
+	// Keeps dd_time_us from missing a wrap of the cycle counter, and tick_to_us in step with it
+	tick_epoch_us = dd_time_us() - (uint32_t)xTaskGetTickCountFromISR() * portTICK_PERIOD_MS * 1000;
+}
+/*-----------------------------------------------------------*/
+
+void vApplicationIdleHook(void)
+{
+	volatile size_t xFreeStackSpace;
+
+	/* The idle task hook is enabled by setting configUSE_IDLE_HOOK to 1 in
+	FreeRTOSConfig.h.
+
+	This function is called on each cycle of the idle task.  In this case it
+	does nothing useful, other than report the amount of FreeRTOS heap that
+	remains unallocated. */
+	xFreeStackSpace = xPortGetFreeHeapSize();
+
+#if configUSE_CO_ROUTINES
+	// Co-routine DD-Tasks share the idle task's stack
+	vCoRoutineSchedule();
+#endif
 
 	if (xFreeStackSpace > 100)
 	{
@@ -38,6 +38,7 @@ SOFTWARE.
 #include <sys/time.h>
 #include <sys/times.h>
 #include "stm32f4xx.h"
+#include "console.h"
 /* Variables */
 #undef errno
 extern int32_t errno;
@@ -76,12 +77,10 @@ void _exit(int32_t status)
 
 int _write(int file, char *ptr, int len)
 {
- /* Implement your write code here, this is used by
-puts and printf for example */
- int i=0;
- for(i=0 ; i<len ; i++)
-	 ITM_SendChar((*ptr++));
- return len;
+ /* Used by puts and printf. Buffered, the console sink sends it in the background.
+Tasks registered with console_block_writes wait for room, for anyone else whatever
+does not fit in the buffer is dropped (console_dropped) */
+ return console_write(ptr, len);
 }
 
 
@@ -0,0 +1,225 @@
+#include <workload.h>
+#include <dd_time.h>
+
+#define WORKLOAD_CALIBRATION_UNITS 64
+#define WORKLOAD_BUFFER_WORDS 4096 // 16KB, split evenly between the contexts
+#define WORKLOAD_SHARE_WORDS (WORKLOAD_BUFFER_WORDS / WORKLOAD_CONTEXTS)
+#define WORKLOAD_STREAM_WORDS 256 // words touched per memory unit
+#define FIR_TAPS WORKLOAD_FIR_TAPS
+#define FIR_BLOCK WORKLOAD_FIR_BLOCK
+#define MATRIX_N WORKLOAD_MATRIX_N
+
+/* Units of each kernel that fit in 1 ms of CPU time, set by workload_calibrate */
+uint32_t units_per_ms[NUM_WORKLOADS];
+
+/* Results are stored here so the compiler cannot drop the kernels */
+volatile uint32_t workload_sink;
+
+uint32_t workload_buffer[WORKLOAD_BUFFER_WORDS];
+
+/* Kernel inputs, written once by workload_calibrate and only read after that */
+float fir_coeffs[FIR_TAPS];
+float fir_input[FIR_BLOCK];
+float matrix_a[MATRIX_N * MATRIX_N];
+float matrix_b[MATRIX_N * MATRIX_N];
+#if WORKLOAD_USE_CMSIS_DSP
+arm_matrix_instance_f32 mat_a;
+arm_matrix_instance_f32 mat_b;
+#endif
+
+/* Used by workload_calibrate only, before any job runs */
+workload_context calibration_context;
+
+void alu_unit(void)
+{
+    uint32_t x = workload_sink | 1;
+    uint32_t i;
+
+    for (i = 0; i < 64; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        x += i * 2654435761UL;
+    }
+    workload_sink = x;
+}
+
+/* Sequential read-modify-write, moving on through the context's share of the buffer so every unit
+   touches new memory. */
+void memory_unit(workload_context *context)
+{
+    uint32_t *p = &context->stream[context->stream_offset];
+    uint32_t sum = 0;
+    uint32_t i;
+
+    for (i = 0; i < WORKLOAD_STREAM_WORDS; i++)
+    {
+        sum += p[i];
+        p[i] = sum ^ i;
+    }
+    context->stream_offset = (context->stream_offset + WORKLOAD_STREAM_WORDS) % WORKLOAD_SHARE_WORDS;
+    workload_sink = sum;
+}
+
+void fir_unit(workload_context *context)
+{
+#if WORKLOAD_USE_CMSIS_DSP
+    arm_fir_f32(&context->fir_instance, fir_input, context->fir_output, FIR_BLOCK);
+#else
+    float *fir_history = context->fir_history;
+    int n, k;
+    float acc;
+
+    // Keep the last FIR_TAPS - 1 inputs in front of the new block, as arm_fir_f32 does
+    for (n = 0; n < FIR_TAPS - 1; n++)
+    {
+        fir_history[n] = fir_history[n + FIR_BLOCK];
+    }
+    for (n = 0; n < FIR_BLOCK; n++)
+    {
+        fir_history[FIR_TAPS - 1 + n] = fir_input[n];
+    }
+    for (n = 0; n < FIR_BLOCK; n++)
+    {
+        acc = 0.0f;
+        for (k = 0; k < FIR_TAPS; k++)
+        {
+            acc += fir_coeffs[k] * fir_history[n + FIR_TAPS - 1 - k];
+        }
+        context->fir_output[n] = acc;
+    }
+#endif
+    workload_sink = (uint32_t)context->fir_output[FIR_BLOCK - 1];
+}
+
+void matrix_unit(workload_context *context)
+{
+#if WORKLOAD_USE_CMSIS_DSP
+    arm_mat_mult_f32(&mat_a, &mat_b, &context->mat_c);
+#else
+    int i, j, k;
+    float acc;
+
+    for (i = 0; i < MATRIX_N; i++)
+    {
+        for (j = 0; j < MATRIX_N; j++)
+        {
+            acc = 0.0f;
+            for (k = 0; k < MATRIX_N; k++)
+            {
+                acc += matrix_a[i * MATRIX_N + k] * matrix_b[k * MATRIX_N + j];
+            }
+            context->matrix_c[i * MATRIX_N + j] = acc;
+        }
+    }
+#endif
+    workload_sink = (uint32_t)context->matrix_c[MATRIX_N * MATRIX_N - 1];
+}
+
+void run_unit(workload_context *context, workload_kind kind)
+{
+    switch (kind)
+    {
+    case WORKLOAD_ALU:
+        alu_unit();
+        break;
+    case WORKLOAD_MEMORY:
+        memory_unit(context);
+        break;
+    case WORKLOAD_FIR:
+        fir_unit(context);
+        break;
+    case WORKLOAD_MATRIX:
+        matrix_unit(context);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Fills the kernel inputs and measures the cost of one unit of each kernel with the cycle
+   counter. Call once before the scheduler starts, so nothing preempts the measurement. */
+void workload_calibrate(void)
+{
+    uint32_t start;
+    uint32_t cycles;
+    int kind;
+    int i;
+
+    for (i = 0; i < FIR_TAPS; i++)
+    {
+        fir_coeffs[i] = 1.0f / (float)(i + 1);
+    }
+    for (i = 0; i < FIR_BLOCK; i++)
+    {
+        fir_input[i] = (float)(i % 7) - 3.0f;
+    }
+    for (i = 0; i < MATRIX_N * MATRIX_N; i++)
+    {
+        matrix_a[i] = (float)(i % 5);
+        matrix_b[i] = (float)(i % 3) - 1.0f;
+    }
+#if WORKLOAD_USE_CMSIS_DSP
+    arm_mat_init_f32(&mat_a, MATRIX_N, MATRIX_N, matrix_a);
+    arm_mat_init_f32(&mat_b, MATRIX_N, MATRIX_N, matrix_b);
+#endif
+    workload_context_init(&calibration_context, 0);
+
+    dd_time_init();
+
+    for (kind = 0; kind < NUM_WORKLOADS; kind++)
+    {
+        run_unit(&calibration_context, (workload_kind)kind); // warm up
+        start = dd_cycles();
+        for (i = 0; i < WORKLOAD_CALIBRATION_UNITS; i++)
+        {
+            run_unit(&calibration_context, (workload_kind)kind);
+        }
+        cycles = dd_cycles() - start;
+
+        units_per_ms[kind] = (uint32_t)((uint64_t)WORKLOAD_CALIBRATION_UNITS * DD_CYCLES_PER_US * 1000 / cycles);
+        if (units_per_ms[kind] == 0)
+        {
+            units_per_ms[kind] = 1;
+        }
+    }
+}
+
+/* Gives a context the index-th share of the memory kernel's buffer and a clean filter state. No two
+   contexts that are in use at the same time may share an index. */
+void workload_context_init(workload_context *context, uint32_t index)
+{
+#if !WORKLOAD_USE_CMSIS_DSP
+    int i;
+#endif
+
+    configASSERT(index < WORKLOAD_CONTEXTS);
+    context->stream = &workload_buffer[index * WORKLOAD_SHARE_WORDS];
+    context->stream_offset = 0;
+#if WORKLOAD_USE_CMSIS_DSP
+    arm_fir_init_f32(&context->fir_instance, FIR_TAPS, fir_coeffs, context->fir_state, FIR_BLOCK);
+    arm_mat_init_f32(&context->mat_c, MATRIX_N, MATRIX_N, context->matrix_c);
+#else
+    for (i = 0; i < FIR_BLOCK + FIR_TAPS - 1; i++)
+    {
+        context->fir_history[i] = 0.0f;
+    }
+#endif
+}
+
+/* Does us microseconds worth of CPU work with the given kernel, rounded up to whole units. */
+void workload_run(workload_context *context, workload_kind kind, uint32_t us)
+{
+    uint32_t units = (uint32_t)(((uint64_t)us * units_per_ms[kind] + 999) / 1000);
+
+    while (units-- > 0)
+    {
+        run_unit(context, kind);
+    }
+}
+
+uint32_t workload_units_per_ms(workload_kind kind)
+{
+    return units_per_ms[kind];
+}
@@ -0,0 +1,57 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+/* Standard includes*/
+#include <stdint.h>
+/* Kernel includes. */
+#include "stm32f4xx.h"
+#include "../FreeRTOS_Source/include/FreeRTOS.h"
+
+/* Set to 1 to run the FIR and matrix kernels through CMSIS-DSP (arm_math.h). Needs ARM_MATH_CM4
+   defined and the CMSIS-DSP library linked, the portable C kernels are used otherwise. */
+#define WORKLOAD_USE_CMSIS_DSP 0
+#if WORKLOAD_USE_CMSIS_DSP
+#include "arm_math.h"
+#endif
+
+#define WORKLOAD_FIR_TAPS 32
+#define WORKLOAD_FIR_BLOCK 64
+#define WORKLOAD_MATRIX_N 8
+/* Contexts that can get their own share of the memory kernel's buffer */
+#define WORKLOAD_CONTEXTS 8
+
+/* Synthetic job bodies. Each kernel is split into small fixed units of work whose cost is measured
+   once by workload_calibrate, so a request for N us of CPU time becomes a fixed amount of work.
+   A job that gets preempted therefore still does all of its work, unlike a wall-clock busy wait. */
+typedef enum workload_kind
+{
+    WORKLOAD_ALU,    // integer xorshift/multiply loop, registers only
+    WORKLOAD_MEMORY, // read-modify-write stream through the context's share of a 16KB buffer
+    WORKLOAD_FIR,    // 32-tap float FIR over a 64-sample block
+    WORKLOAD_MATRIX, // 8x8 float matrix multiply
+    NUM_WORKLOADS
+} workload_kind;
+
+/* Everything the kernels write. Jobs that can run at the same time or preempt each other need
+   separate contexts, one per worker, while coefficients and inputs are shared read-only. */
+typedef struct workload_context
+{
+    uint32_t *stream; // share of the memory kernel's buffer
+    uint32_t stream_offset;
+    float fir_output[WORKLOAD_FIR_BLOCK];
+    float matrix_c[WORKLOAD_MATRIX_N * WORKLOAD_MATRIX_N];
+#if WORKLOAD_USE_CMSIS_DSP
+    float fir_state[WORKLOAD_FIR_BLOCK + WORKLOAD_FIR_TAPS - 1];
+    arm_fir_instance_f32 fir_instance;
+    arm_matrix_instance_f32 mat_c;
+#else
+    float fir_history[WORKLOAD_FIR_BLOCK + WORKLOAD_FIR_TAPS - 1];
+#endif
+} workload_context;
+
+void workload_calibrate(void);
+void workload_context_init(workload_context *context, uint32_t index);
+void workload_run(workload_context *context, workload_kind kind, uint32_t us);
+uint32_t workload_units_per_ms(workload_kind kind);
+
+#endif
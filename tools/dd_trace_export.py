@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""Converts a DDS scheduler trace into Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+
+The input is either a raw dump of dd_trace_log from the target
+
+    (gdb) dump binary value trace.bin dd_trace_log_buffer
+
+or a console log holding the TRACE lines printed by dd_trace_print (TRACE_STREAM in main.c),
+which can cover an arbitrarily long run.
+
+    python3 dd_trace_export.py trace.bin -o trace.json
+
+Each worker gets a track showing the jobs it ran, split where they were preempted. Each task gets a
+track with its releases and deadline misses, and every job is an async span from release to
+completion, so response times can be read off directly. Kernel events (DD_TRACE_KERNEL in
+FreeRTOSConfig.h) add a CPU track with the running task between context switches, a depth counter
+for each numbered DDS queue, and instants for priority changes, notifications and blocking on a
+queue. Task and queue names come from the TRACE-TASK and TRACE-QUEUE lines when present.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = 0x45435254
+HEADER = struct.Struct("<6I")
+EVENT = struct.Struct("<IIIHBB")
+
+# dd_trace_type in dd_trace.h
+RELEASE, DISPATCH, PREEMPT, RESUME, COMPLETE, MISS = range(6)
+SWITCH_IN, PRIORITY_SET, NOTIFY, QUEUE_SEND, QUEUE_RECEIVE, QUEUE_BLOCK_TX, QUEUE_BLOCK_RX = range(6, 13)
+KERNEL_SLOT = 0xFF
+
+WORKER_PID = 1
+TASK_PID = 2
+KERNEL_PID = 3
+
+# vQueueSetQueueNumber in myDDS_Init, overridden by TRACE-QUEUE lines
+QUEUE_NAMES = {1: "events", 2: "queries", 3: "responses", 4: "callbacks"}
+
+
+def read_binary(data):
+    magic, version, capacity, cycles_per_us, tick_rate_hz, head = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        raise ValueError("not a dd_trace_log dump (bad magic 0x%08x)" % magic)
+    if version not in (1, 2):
+        raise ValueError("unsupported trace version %d" % version)
+    events = []
+    for seq in range(max(0, head - capacity), head):
+        offset = HEADER.size + (seq % capacity) * EVENT.size
+        events.append((seq,) + EVENT.unpack_from(data, offset))
+    return cycles_per_us, tick_rate_hz, events, {}, dict(QUEUE_NAMES)
+
+
+def read_text(lines):
+    cycles_per_us = tick_rate_hz = None
+    events = {}
+    task_names = {}
+    queue_names = dict(QUEUE_NAMES)
+    for line in lines:
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == "TRACE-HDR":
+            cycles_per_us, tick_rate_hz = int(fields[1]), int(fields[2])
+        elif fields[0] == "TRACE" and len(fields) == 8:
+            seq, cycles, tick, task_id, task_number, kind, slot = (int(f) for f in fields[1:])
+            events[seq] = (seq, cycles, tick, task_id, task_number, kind, slot)
+        elif fields[0] in ("TRACE-TASK", "TRACE-QUEUE") and len(fields) >= 3:
+            names = task_names if fields[0] == "TRACE-TASK" else queue_names
+            names[int(fields[1])] = " ".join(fields[2:])
+    if cycles_per_us is None:
+        raise ValueError("no TRACE-HDR line in the log")
+    return cycles_per_us, tick_rate_hz, [events[seq] for seq in sorted(events)], task_names, queue_names
+
+
+def unwrap(events, cycles_per_us, tick_rate_hz):
+    """Extends the 32-bit cycle stamps to microseconds since the first event. The tick gives the
+    coarse time, so gaps longer than a cycle counter wrap (about 25 s at 168 MHz) are handled."""
+    cycles_per_tick = cycles_per_us * 1000000 // tick_rate_hz
+    offset = None
+    out = []
+    for seq, cycles, tick, task_id, task_number, kind, slot in events:
+        estimate = tick * cycles_per_tick
+        if offset is None:
+            offset = cycles - (estimate & 0xFFFFFFFF)
+        estimate += offset
+        delta = (cycles - estimate) & 0xFFFFFFFF
+        if delta >= 1 << 31:
+            delta -= 1 << 32
+        out.append((estimate + delta, seq, task_id, task_number, kind, slot))
+    if not out:
+        return []
+    start = out[0][0]
+    return [((event[0] - start) / cycles_per_us,) + event[1:] for event in out]
+
+
+def export(events, task_names, queue_names):
+    trace = []
+    running = {}  # slot -> (start us, task_id, task_number)
+    workers = set()
+    tasks = set()
+    cpu = None  # (start us, TCB number, priority) of the task switched in last
+
+    def task_name(number):
+        return task_names.get(number, "task #%d" % number)
+
+    def queue_name(number):
+        return queue_names.get(number, "queue #%d" % number)
+
+    def close_slice(slot, ts):
+        start, task_id, task_number = running.pop(slot)
+        trace.append({"name": "task %d" % task_number, "cat": "job", "ph": "X", "pid": WORKER_PID,
+                      "tid": slot, "ts": start, "dur": ts - start, "args": {"job": task_id}})
+
+    for ts, seq, task_id, task_number, kind, slot in events:
+        if kind == SWITCH_IN:
+            if cpu is not None:
+                trace.append({"name": task_name(cpu[1]), "cat": "kernel", "ph": "X", "pid": KERNEL_PID,
+                              "tid": 0, "ts": cpu[0], "dur": ts - cpu[0], "args": {"priority": cpu[2]}})
+            cpu = (ts, task_id, task_number)
+            continue
+        if kind == PRIORITY_SET:
+            trace.append({"name": "priority %d" % task_number, "ph": "i", "s": "t", "pid": KERNEL_PID,
+                          "tid": 1, "ts": ts, "args": {"task": task_name(task_id)}})
+            continue
+        if kind == NOTIFY:
+            trace.append({"name": "notify", "ph": "i", "s": "t", "pid": KERNEL_PID, "tid": 1, "ts": ts,
+                          "args": {"task": task_name(task_id)}})
+            continue
+        if kind in (QUEUE_SEND, QUEUE_RECEIVE):
+            # The hooks run before the copy, so the depth afterwards is one more or one less
+            depth = task_number + 1 if kind == QUEUE_SEND else task_number - 1
+            if task_id != 0:
+                trace.append({"name": queue_name(task_id), "ph": "C", "pid": KERNEL_PID, "ts": ts,
+                              "args": {"depth": max(depth, 0)}})
+            continue
+        if kind in (QUEUE_BLOCK_TX, QUEUE_BLOCK_RX):
+            if task_id != 0:
+                blocked = "full" if kind == QUEUE_BLOCK_TX else "empty"
+                trace.append({"name": "%s %s" % (queue_name(task_id), blocked), "ph": "i", "s": "t",
+                              "pid": KERNEL_PID, "tid": 1, "ts": ts})
+            continue
+
+        tasks.add(task_number)
+        if kind == RELEASE:
+            trace.append({"name": "release", "ph": "i", "s": "t", "pid": TASK_PID, "tid": task_number,
+                          "ts": ts, "args": {"job": task_id}})
+            trace.append({"name": "task %d" % task_number, "cat": "response", "ph": "b", "id": task_id,
+                          "pid": TASK_PID, "tid": task_number, "ts": ts})
+        elif kind == MISS:
+            trace.append({"name": "deadline miss", "ph": "i", "s": "t", "pid": TASK_PID, "tid": task_number,
+                          "ts": ts, "args": {"job": task_id}})
+        elif kind in (DISPATCH, RESUME):
+            if slot in running:
+                close_slice(slot, ts)
+            workers.add(slot)
+            running[slot] = (ts, task_id, task_number)
+        elif kind == PREEMPT:
+            if slot in running:
+                close_slice(slot, ts)
+        elif kind == COMPLETE:
+            if slot in running:
+                close_slice(slot, ts)
+            trace.append({"name": "task %d" % task_number, "cat": "response", "ph": "e", "id": task_id,
+                          "pid": TASK_PID, "tid": task_number, "ts": ts})
+
+    trace.append({"name": "process_name", "ph": "M", "pid": WORKER_PID, "args": {"name": "workers"}})
+    trace.append({"name": "process_name", "ph": "M", "pid": TASK_PID, "args": {"name": "tasks"}})
+    trace.append({"name": "process_name", "ph": "M", "pid": KERNEL_PID, "args": {"name": "kernel"}})
+    trace.append({"name": "thread_name", "ph": "M", "pid": KERNEL_PID, "tid": 0, "args": {"name": "cpu"}})
+    trace.append({"name": "thread_name", "ph": "M", "pid": KERNEL_PID, "tid": 1, "args": {"name": "events"}})
+    for slot in sorted(workers):
+        trace.append({"name": "thread_name", "ph": "M", "pid": WORKER_PID, "tid": slot,
+                      "args": {"name": "worker %d" % slot}})
+    for task_number in sorted(tasks):
+        trace.append({"name": "thread_name", "ph": "M", "pid": TASK_PID, "tid": task_number,
+                      "args": {"name": "task %d" % task_number}})
+    return {"traceEvents": trace, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="binary dump of dd_trace_log_buffer, or a console log with TRACE lines")
+    parser.add_argument("-o", "--output", help="output file (default: stdout)")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+    if len(data) >= HEADER.size and struct.unpack_from("<I", data)[0] == MAGIC:
+        cycles_per_us, tick_rate_hz, events, task_names, queue_names = read_binary(data)
+    else:
+        cycles_per_us, tick_rate_hz, events, task_names, queue_names = read_text(
+            data.decode("ascii", "replace").splitlines())
+
+    trace = export(unwrap(events, cycles_per_us, tick_rate_hz), task_names, queue_names)
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+    print("%d events, %d trace records" % (len(events), len(trace["traceEvents"])), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()